@@ -2,20 +2,25 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <queue>
+#include <deque>
 #include <future>
 #include <functional>
 #include <atomic>
+#include <cstdint>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
+#include <iomanip>
 #include <filesystem>
 #include <exception>
 #include <typeinfo>
@@ -35,8 +40,31 @@ enum class ProcessorType {
     AUTO
 };
 
+enum class InputMode {
+    BUFFERED,
+    MMAP,
+    ASYNC
+};
+
+enum class SchedulePolicy {
+    SUBMISSION,
+    LARGEST_FIRST,
+    SMALLEST_FIRST
+};
+
+enum class QueueFullPolicy {
+    BLOCK,
+    FAIL
+};
+
+enum class ReportFormat {
+    FILES,
+    NDJSON
+};
+
 struct ProcessResult {
     bool success;
+    std::string input_path;
     std::string message;
     size_t bytes_processed;
     std::chrono::milliseconds processing_time;
@@ -49,6 +77,10 @@ struct ProcessingStats {
     std::atomic<size_t> files_processed{0};
     std::atomic<size_t> bytes_processed{0};
     std::atomic<size_t> errors{0};
+    std::atomic<size_t> files_skipped{0};
+    std::atomic<size_t> bytes_skipped{0};
+    std::atomic<uint64_t> busy_microseconds{0};
+    std::atomic<uint64_t> longest_task_microseconds{0};
     std::chrono::steady_clock::time_point start_time;
     std::chrono::steady_clock::time_point end_time;
     
@@ -64,6 +96,23 @@ struct ProcessingStats {
         double duration = get_duration_seconds();
         return duration > 0 ? (bytes_processed.load() / (1024.0 * 1024.0)) / duration : 0.0;
     }
+    
+    void record_task(std::chrono::microseconds duration) {
+        uint64_t micros = static_cast<uint64_t>(duration.count());
+        busy_microseconds += micros;
+        
+        uint64_t longest = longest_task_microseconds.load();
+        while (micros > longest && !longest_task_microseconds.compare_exchange_weak(longest, micros)) {
+        }
+    }
+    
+    // Best possible makespan for the recorded task times on the given
+    // number of workers: the work spread perfectly, but never below the
+    // longest task.
+    double get_ideal_makespan_seconds(size_t workers) const {
+        double spread = busy_microseconds.load() / 1e6 / std::max<size_t>(workers, 1);
+        return std::max(spread, longest_task_microseconds.load() / 1e6);
+    }
 };
 
 template<typename T>
@@ -72,12 +121,30 @@ private:
     mutable std::mutex mutex_;
     std::queue<T> queue_;
     std::condition_variable condition_;
+    std::condition_variable not_full_;
+    size_t capacity_;
 
 public:
+    // capacity == 0 means unbounded; otherwise push() blocks and
+    // try_push() fails while the queue holds capacity items.
+    explicit ThreadSafeQueue(size_t capacity = 0) : capacity_(capacity) {}
+    
     void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return !full(); });
+        queue_.push(std::move(item));
+        condition_.notify_one();
+    }
+    
+    // item is only moved from when the push succeeds.
+    bool try_push(T&& item) {
         std::lock_guard<std::mutex> lock(mutex_);
-        queue_.push(item);
+        if (full()) {
+            return false;
+        }
+        queue_.push(std::move(item));
         condition_.notify_one();
+        return true;
     }
     
     bool try_pop(T& item) {
@@ -85,8 +152,9 @@ public:
         if(queue_.empty()) {
             return false;
         }
-        item = queue_.front();
+        item = std::move(queue_.front());
         queue_.pop();
+        not_full_.notify_one();
         return true;
     }
     
@@ -95,8 +163,9 @@ public:
         while(queue_.empty()) {
             condition_.wait(lock);
         }
-        item = queue_.front();
+        item = std::move(queue_.front());
         queue_.pop();
+        not_full_.notify_one();
     }
     
     bool empty() const {
@@ -108,4 +177,170 @@ public:
         std::lock_guard<std::mutex> lock(mutex_);
         return queue_.size();
     }
-};
\ No newline at end of file
+    
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    bool full() const {
+        return capacity_ > 0 && queue_.size() >= capacity_;
+    }
+};
+
+// Bounded lock-free multi-producer/multi-consumer ring buffer with the same
+// interface as ThreadSafeQueue. Each cell carries a sequence number that
+// tells producers and consumers whose turn it is, so push and pop cost one
+// CAS on the shared index and no lock. Blocking calls spin briefly and then
+// sleep on an atomic epoch counter, so waiting never burns a core; the
+// epoch is only touched while someone sleeps on it. Cells and the shared
+// counters sit on their own cache lines.
+template<typename T>
+class LockFreeQueue {
+private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    
+    static constexpr size_t kSpinLimit = 64;
+    
+    std::unique_ptr<Cell[]> buffer_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    alignas(64) std::atomic<uint32_t> push_epoch_{0};
+    std::atomic<size_t> waiting_consumers_{0};
+    alignas(64) std::atomic<uint32_t> pop_epoch_{0};
+    std::atomic<size_t> waiting_producers_{0};
+
+public:
+    // capacity is rounded up to a power of two.
+    explicit LockFreeQueue(size_t capacity = 1024) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        buffer_ = std::make_unique<Cell[]>(rounded);
+        mask_ = rounded - 1;
+        for (size_t i = 0; i < rounded; ++i) {
+            buffer_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+    
+    void push(T item) {
+        for (size_t spins = 0; !try_push(std::move(item)); ++spins) {
+            if (spins < kSpinLimit) {
+                std::this_thread::yield();
+                continue;
+            }
+            wait_on(pop_epoch_, waiting_producers_, [this, &item] { return try_push(std::move(item)); });
+            return;
+        }
+    }
+    
+    // item is only moved from when the push succeeds.
+    bool try_push(T&& item) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &buffer_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        signal(push_epoch_, waiting_consumers_);
+        return true;
+    }
+    
+    bool try_pop(T& item) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &buffer_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        
+        item = std::move(cell->data);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        signal(pop_epoch_, waiting_producers_);
+        return true;
+    }
+    
+    void wait_and_pop(T& item) {
+        for (size_t spins = 0; !try_pop(item); ++spins) {
+            if (spins < kSpinLimit) {
+                std::this_thread::yield();
+                continue;
+            }
+            wait_on(push_epoch_, waiting_consumers_, [this, &item] { return try_pop(item); });
+            return;
+        }
+    }
+    
+    bool empty() const {
+        return size() == 0;
+    }
+    
+    size_t size() const {
+        size_t head = dequeue_pos_.load(std::memory_order_acquire);
+        size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    // A waiter registers, fences, then samples the epoch and retries; a
+    // signaller publishes its cell, fences, then checks for waiters. The
+    // two fences guarantee that either the signaller sees the waiter and
+    // bumps the epoch, or the waiter's retry sees the cell, so a wakeup
+    // cannot be lost. With nobody waiting, signalling only reads a counter.
+    void signal(std::atomic<uint32_t>& epoch, std::atomic<size_t>& waiters) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            epoch.fetch_add(1, std::memory_order_release);
+            epoch.notify_all();
+        }
+    }
+    
+    template<typename Attempt>
+    void wait_on(std::atomic<uint32_t>& epoch, std::atomic<size_t>& waiters, Attempt attempt) {
+        ++waiters;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (true) {
+            uint32_t observed = epoch.load();
+            if (attempt()) {
+                break;
+            }
+            epoch.wait(observed);
+        }
+        --waiters;
+    }
+};
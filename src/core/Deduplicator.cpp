@@ -0,0 +1,116 @@
+#include "Deduplicator.h"
+#include "InputFile.h"
+#include "../utils/ContentHash.h"
+
+namespace {
+
+// Analyses in progress on this thread, including ones entered while
+// helping the pool. A copy found at that point must not wait for its
+// twin: the twin may be an analysis further down this very stack, or on
+// another thread that is itself waiting for one of ours.
+thread_local size_t analyses_in_progress = 0;
+
+ProcessResult analyze_guarded(const std::function<ProcessResult()>& analyze) {
+    ++analyses_in_progress;
+    try {
+        ProcessResult result = analyze();
+        --analyses_in_progress;
+        return result;
+    } catch (...) {
+        --analyses_in_progress;
+        throw;
+    }
+}
+
+}
+
+Deduplicator::Deduplicator(ThreadPool& pool, size_t split_threshold)
+    : pool_(pool), split_threshold_(split_threshold), duplicates_(0), bytes_saved_(0) {}
+
+ProcessResult Deduplicator::process(IFileProcessor& processor, const std::string& filepath) {
+    // Empty files cannot be mapped but still have contents to compare.
+    InputFile input;
+    if (!input.open(filepath, InputMode::MMAP) || (!input.is_mapped() && input.size() > 0)) {
+        return analyze_guarded([&]() { return processor.process(filepath); });
+    }
+    
+    std::string_view contents = input.is_mapped() ? input.view() : std::string_view();
+    bool split = split_threshold_ > 0 && contents.size() >= split_threshold_;
+    return run_once(processor, filepath, contents, [&]() {
+        return split ? processor.process(filepath) : processor.process_contents(filepath, contents);
+    });
+}
+
+ProcessResult Deduplicator::process_contents(IFileProcessor& processor, const std::string& filepath,
+                                             std::string_view contents) {
+    return run_once(processor, filepath, contents, [&]() {
+        return processor.process_contents(filepath, contents);
+    });
+}
+
+ProcessResult Deduplicator::run_once(IFileProcessor& processor, const std::string& filepath,
+                                     std::string_view contents, const std::function<ProcessResult()>& analyze) {
+    Key key{contents.size(), ContentHasher::hash(contents)};
+    Shard& shard = shards_[key.hash % kShards];
+    
+    std::promise<ProcessResult> promise;
+    std::shared_future<ProcessResult> first;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.results.try_emplace(key);
+        if (inserted) {
+            it->second = promise.get_future().share();
+        } else {
+            first = it->second;
+        }
+    }
+    
+    auto analyze_hashed = [&]() {
+        ProcessResult result = analyze_guarded(analyze);
+        if (result.success) {
+            result.metadata["content_hash"] = std::to_string(key.hash);
+        }
+        return result;
+    };
+    
+    if (!first.valid()) {
+        ProcessResult result;
+        try {
+            result = analyze_hashed();
+        } catch (const std::exception& e) {
+            result.input_path = filepath;
+            result.message = "Processing failed: " + std::string(e.what());
+        }
+        promise.set_value(result);
+        return result;
+    }
+    
+    if (analyses_in_progress > 0 && first.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return analyze_hashed();
+    }
+    
+    pool_.help_until_ready(first);
+    const ProcessResult& original = first.get();
+    if (!original.success) {
+        return analyze_hashed();
+    }
+    
+    ++duplicates_;
+    bytes_saved_ += contents.size();
+    return processor.share_result(filepath, original);
+}
+
+void Deduplicator::clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.results.clear();
+    }
+}
+
+size_t Deduplicator::duplicates() const {
+    return duplicates_.load();
+}
+
+size_t Deduplicator::bytes_saved() const {
+    return bytes_saved_.load();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../../include/common.h"
+#include "FileProcessor.h"
+#include "ThreadPool.h"
+
+// Analyzes each distinct file content once per run. Files are keyed by
+// size and XXH64 of their contents; the first file with a key is analyzed
+// and every later one shares its result through
+// IFileProcessor::share_result(). A file whose twin is still being
+// analyzed helps with other pool tasks until the result is ready. If the
+// first analysis failed, the copies are analyzed on their own.
+//
+// Two different files are only confused if both their sizes and 64-bit
+// hashes collide; contents are not compared byte by byte. Results of
+// hashed files carry that hash in metadata["content_hash"], like
+// IFileProcessor::set_content_hashing(), so it is not computed twice.
+class Deduplicator {
+public:
+    // Files of at least split_threshold bytes are analyzed through
+    // process() so they can still be split into ranges; 0 never splits.
+    Deduplicator(ThreadPool& pool, size_t split_threshold);
+    
+    Deduplicator(const Deduplicator&) = delete;
+    Deduplicator& operator=(const Deduplicator&) = delete;
+    
+    // Maps the file to hash it, then analyzes it from the mapping unless
+    // its contents were already seen.
+    ProcessResult process(IFileProcessor& processor, const std::string& filepath);
+    
+    // Same for contents already in memory, e.g. from a ReadEngine.
+    ProcessResult process_contents(IFileProcessor& processor, const std::string& filepath,
+                                   std::string_view contents);
+    
+    // Forgets every content seen so far. Call between runs over files that
+    // may have changed since, so a copy never gets a report that was
+    // overwritten in the meantime.
+    void clear();
+    
+    size_t duplicates() const;
+    size_t bytes_saved() const;
+    
+private:
+    struct Key {
+        uint64_t size;
+        uint64_t hash;
+        
+        bool operator==(const Key& other) const {
+            return size == other.size && hash == other.hash;
+        }
+    };
+    
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.hash ^ (key.size * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+    
+    // Sharded so concurrent lookups rarely share a lock.
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, std::shared_future<ProcessResult>, KeyHash> results;
+    };
+    
+    static constexpr size_t kShards = 16;
+    
+    ThreadPool& pool_;
+    size_t split_threshold_;
+    Shard shards_[kShards];
+    std::atomic<size_t> duplicates_;
+    std::atomic<size_t> bytes_saved_;
+    
+    ProcessResult run_once(IFileProcessor& processor, const std::string& filepath, std::string_view contents,
+                           const std::function<ProcessResult()>& analyze);
+};
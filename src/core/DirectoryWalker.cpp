@@ -0,0 +1,314 @@
+#include "DirectoryWalker.h"
+#include "../utils/Logger.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr unsigned kStatxMask = STATX_TYPE | STATX_SIZE | STATX_INO | STATX_MTIME;
+
+// AT_STATX_DONT_SYNC lets network filesystems answer from their cache.
+bool stat_entry(int dir_fd, const char* name, bool follow, struct statx& st) {
+    int flags = AT_STATX_DONT_SYNC | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+    return statx(dir_fd, name, flags, kStatxMask, &st) == 0;
+}
+
+void fill_entry(DirectoryWalker::Entry& entry, const struct statx& st) {
+    entry.size = st.stx_size;
+    entry.mtime_ns = int64_t(st.stx_mtime.tv_sec) * 1000000000 + st.stx_mtime.tv_nsec;
+    entry.device = (uint64_t(st.stx_dev_major) << 32) | st.stx_dev_minor;
+    entry.inode = st.stx_ino;
+}
+
+std::string join_path(const std::string& directory, const char* name) {
+    if (!directory.empty() && directory.back() == '/') {
+        return directory + name;
+    }
+    return directory + "/" + name;
+}
+
+}
+
+struct DirectoryWalker::Scan {
+    std::string path;
+    DIR* dir = nullptr;
+    
+    // A file found while found_ was full; sent first when resumed.
+    Entry unsent;
+    
+    ~Scan() {
+        if (dir) {
+            closedir(dir);
+        }
+    }
+};
+
+DirectoryWalker::DirectoryWalker(ThreadPool& pool, size_t capacity)
+    : pool_(pool), found_(std::max<size_t>(capacity, 1)), pending_directories_(0),
+      end_paused_(false), abandoned_(false), paused_count_(0), files_found_(0), bytes_found_(0),
+      duplicates_skipped_(0), started_(false), drained_(false), walk_done_(false) {}
+
+DirectoryWalker::~DirectoryWalker() {
+    if (started_) {
+        std::vector<std::shared_ptr<Scan>> scans;
+        {
+            std::lock_guard<std::mutex> lock(paused_mutex_);
+            abandoned_ = true;
+            scans.swap(paused_);
+        }
+        for (size_t i = 0; i < scans.size(); ++i) {
+            finish_directory();
+        }
+        
+        std::unique_lock<std::mutex> lock(finished_mutex_);
+        finished_.wait(lock, [this] { return walk_done_; });
+    }
+}
+
+void DirectoryWalker::start(const std::string& root) {
+    started_ = true;
+    
+    struct statx st;
+    if (!stat_entry(AT_FDCWD, root.c_str(), true, st)) {
+        LOG_WARNING("Cannot access input: {}", root);
+        finish_walk();
+        return;
+    }
+    
+    if (S_ISREG(st.stx_mode)) {
+        found_.push(found_file(root, st));
+        finish_walk();
+    } else if (S_ISDIR(st.stx_mode)) {
+        pending_directories_ = 1;
+        schedule_directory(root);
+    } else {
+        finish_walk();
+    }
+}
+
+bool DirectoryWalker::next(Entry& entry) {
+    if (drained_ || !started_) {
+        return false;
+    }
+    
+    found_.wait_and_pop(entry);
+    if (paused_count_.load() > 0 && found_.size() <= found_.capacity() / 2) {
+        resume_paused();
+    }
+    if (entry.path.empty()) {
+        drained_ = true;
+        return false;
+    }
+    return true;
+}
+
+void DirectoryWalker::order_for_schedule(std::vector<Entry>& entries, SchedulePolicy policy) {
+    if (policy == SchedulePolicy::LARGEST_FIRST) {
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.size > b.size; });
+    } else if (policy == SchedulePolicy::SMALLEST_FIRST) {
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.size < b.size; });
+    }
+}
+
+bool DirectoryWalker::stat_file(const std::string& path, Entry& entry) {
+    struct statx st;
+    if (!stat_entry(AT_FDCWD, path.c_str(), true, st) || !S_ISREG(st.stx_mode)) {
+        return false;
+    }
+    entry.path = path;
+    fill_entry(entry, st);
+    return true;
+}
+
+size_t DirectoryWalker::files_found() const {
+    return files_found_.load();
+}
+
+size_t DirectoryWalker::bytes_found() const {
+    return bytes_found_.load();
+}
+
+size_t DirectoryWalker::duplicates_skipped() const {
+    return duplicates_skipped_.load();
+}
+
+// The caller has already counted path in pending_directories_.
+void DirectoryWalker::schedule_directory(std::string path) {
+    auto scan = std::make_shared<Scan>();
+    scan->path = std::move(path);
+    schedule_scan(std::move(scan));
+}
+
+void DirectoryWalker::schedule_scan(std::shared_ptr<Scan> scan) {
+    try {
+        pool_.enqueue([this, scan = std::move(scan)]() {
+            if (walk_directory(scan)) {
+                finish_directory();
+            }
+        });
+    } catch (const std::exception& e) {
+        LOG_ERROR("Cannot schedule directory scan: {}", e.what());
+        finish_directory();
+    }
+}
+
+// Reads the scan's directory from where it stopped. Returns false if it
+// was parked again before reaching the end.
+bool DirectoryWalker::walk_directory(const std::shared_ptr<Scan>& scan) {
+    const std::string& path = scan->path;
+    if (!scan->dir) {
+        scan->dir = opendir(path.c_str());
+        if (!scan->dir) {
+            LOG_WARNING("Cannot read directory: {}", path);
+            return true;
+        }
+    }
+    if (!scan->unsent.path.empty() && !send(scan)) {
+        return false;
+    }
+    
+    int dir_fd = dirfd(scan->dir);
+    while (struct dirent* entry = readdir(scan->dir)) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        
+        unsigned char type = entry->d_type;
+        if (type == DT_DIR) {
+            ++pending_directories_;
+            schedule_directory(join_path(path, name));
+            continue;
+        }
+        if (type != DT_REG && type != DT_LNK && type != DT_UNKNOWN) {
+            continue;
+        }
+        
+        struct statx st;
+        if (!stat_entry(dir_fd, name, type == DT_LNK, st)) {
+            LOG_WARNING("Cannot stat file: {}", join_path(path, name));
+            continue;
+        }
+        
+        // Only filesystems without d_type get here with a directory or an
+        // unresolved symlink.
+        if (type == DT_UNKNOWN && S_ISDIR(st.stx_mode)) {
+            ++pending_directories_;
+            schedule_directory(join_path(path, name));
+            continue;
+        }
+        if (type == DT_UNKNOWN && S_ISLNK(st.stx_mode) && !stat_entry(dir_fd, name, true, st)) {
+            continue;
+        }
+        if (!S_ISREG(st.stx_mode)) {
+            continue;
+        }
+        
+        FileId id{(uint64_t(st.stx_dev_major) << 32) | st.stx_dev_minor, st.stx_ino};
+        if (!first_sighting(id)) {
+            ++duplicates_skipped_;
+            continue;
+        }
+        
+        scan->unsent = found_file(join_path(path, name), st);
+        if (!send(scan)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// Queues the scan's unsent file. If found_ is full the scan is parked for
+// next() to resume and false is returned; the caller must then stop
+// without finishing the directory.
+bool DirectoryWalker::send(const std::shared_ptr<Scan>& scan) {
+    if (found_.try_push(std::move(scan->unsent))) {
+        scan->unsent.path.clear();
+        return true;
+    }
+    
+    bool abandoned;
+    {
+        std::lock_guard<std::mutex> lock(paused_mutex_);
+        abandoned = abandoned_;
+        if (!abandoned) {
+            // Counted before retrying: next() has either made room
+            // already or sees the scan after its next pop.
+            paused_.push_back(scan);
+            ++paused_count_;
+            if (found_.try_push(std::move(scan->unsent))) {
+                scan->unsent.path.clear();
+                paused_.pop_back();
+                --paused_count_;
+                return true;
+            }
+        }
+    }
+    
+    if (abandoned) {
+        finish_directory();
+    }
+    return false;
+}
+
+void DirectoryWalker::resume_paused() {
+    std::vector<std::shared_ptr<Scan>> scans;
+    bool end;
+    {
+        std::lock_guard<std::mutex> lock(paused_mutex_);
+        scans.swap(paused_);
+        end = end_paused_;
+        end_paused_ = false;
+        paused_count_ = 0;
+    }
+    
+    for (auto& scan : scans) {
+        schedule_scan(std::move(scan));
+    }
+    if (end) {
+        found_.push(Entry{});
+    }
+}
+
+void DirectoryWalker::finish_directory() {
+    if (--pending_directories_ == 0) {
+        finish_walk();
+    }
+}
+
+// An empty entry marks the end of the stream for next(). It waits with
+// the parked scans if found_ is full.
+void DirectoryWalker::finish_walk() {
+    if (!found_.try_push(Entry{})) {
+        std::lock_guard<std::mutex> lock(paused_mutex_);
+        end_paused_ = true;
+        ++paused_count_;
+        if (found_.try_push(Entry{})) {
+            end_paused_ = false;
+            --paused_count_;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(finished_mutex_);
+    walk_done_ = true;
+    finished_.notify_all();
+}
+
+bool DirectoryWalker::first_sighting(const FileId& id) {
+    std::lock_guard<std::mutex> lock(seen_mutex_);
+    return seen_.insert(id).second;
+}
+
+DirectoryWalker::Entry DirectoryWalker::found_file(std::string path, const struct statx& st) {
+    Entry entry;
+    entry.path = std::move(path);
+    fill_entry(entry, st);
+    
+    ++files_found_;
+    bytes_found_ += entry.size;
+    return entry;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../../include/common.h"
+#include "ThreadPool.h"
+
+struct statx;
+
+// Walks a directory tree in parallel on a ThreadPool, one task per
+// directory, and streams the regular files it finds to a single consumer
+// through next(). Each file's size comes from the same statx() call that
+// classifies it, so no second pass is needed. Files reached more than
+// once through hard links or symlinks (same device and inode) are
+// reported once. Symlinked directories are not followed.
+//
+// At most capacity found files wait for the consumer. A directory task
+// that finds the queue full does not block its worker, which may be
+// needed for the very tasks the consumer waits on: it parks, keeping its
+// place in the directory, and next() hands it back to the pool once the
+// consumer has drained half the queue.
+class DirectoryWalker {
+public:
+    // Size, modification time and identity as of the scan.
+    struct Entry {
+        std::string path;
+        size_t size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t device = 0;
+        uint64_t inode = 0;
+    };
+    
+    static constexpr size_t kDefaultCapacity = 4096;
+    
+    explicit DirectoryWalker(ThreadPool& pool, size_t capacity = kDefaultCapacity);
+    
+    // Waits for any directory tasks still running on the pool. Parked
+    // directories are abandoned, so the walk need not have been drained.
+    ~DirectoryWalker();
+    
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+    
+    // Starts walking root, which may also be a single file. Call once.
+    void start(const std::string& root);
+    
+    // Blocks until the next file is found; returns false once the walk is
+    // complete and every file has been returned.
+    bool next(Entry& entry);
+    
+    // Orders a fully collected file list for the given policy; equal
+    // sizes keep their discovery order.
+    static void order_for_schedule(std::vector<Entry>& entries, SchedulePolicy policy);
+    
+    // Stats a single path, following symlinks, as the walk would. Returns
+    // false if it is missing or not a regular file.
+    static bool stat_file(const std::string& path, Entry& entry);
+    
+    size_t files_found() const;
+    size_t bytes_found() const;
+    size_t duplicates_skipped() const;
+
+private:
+    // A directory being read; defined in the .cpp.
+    struct Scan;
+    
+    struct FileId {
+        uint64_t device;
+        uint64_t inode;
+        
+        bool operator==(const FileId& other) const {
+            return device == other.device && inode == other.inode;
+        }
+    };
+    
+    struct FileIdHash {
+        size_t operator()(const FileId& id) const {
+            return std::hash<uint64_t>()(id.inode * 0x9E3779B97F4A7C15ULL ^ id.device);
+        }
+    };
+    
+    ThreadPool& pool_;
+    ThreadSafeQueue<Entry> found_;
+    std::atomic<size_t> pending_directories_;
+    
+    // Scans waiting for room in found_, and whether the end marker is
+    // waiting too. paused_count_ counts both, so next() can skip the lock.
+    std::mutex paused_mutex_;
+    std::vector<std::shared_ptr<Scan>> paused_;
+    bool end_paused_;
+    bool abandoned_;
+    std::atomic<size_t> paused_count_;
+    
+    std::atomic<size_t> files_found_;
+    std::atomic<size_t> bytes_found_;
+    std::atomic<size_t> duplicates_skipped_;
+    std::mutex seen_mutex_;
+    std::unordered_set<FileId, FileIdHash> seen_;
+    std::mutex finished_mutex_;
+    std::condition_variable finished_;
+    bool started_;
+    bool drained_;
+    bool walk_done_;
+    
+    void schedule_directory(std::string path);
+    void schedule_scan(std::shared_ptr<Scan> scan);
+    bool walk_directory(const std::shared_ptr<Scan>& scan);
+    bool send(const std::shared_ptr<Scan>& scan);
+    void resume_paused();
+    void finish_directory();
+    void finish_walk();
+    bool first_sighting(const FileId& id);
+    Entry found_file(std::string path, const struct statx& st);
+};
@@ -0,0 +1,306 @@
+#include "DirectoryWatcher.h"
+#include "../utils/Logger.h"
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// IN_MODIFY only postpones a file that is still being written; the
+// report normally follows IN_CLOSE_WRITE or IN_MOVED_TO, whichever the
+// writer ends with.
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM |
+                                IN_DELETE | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+std::string join_path(const std::string& directory, const char* name) {
+    if (!directory.empty() && directory.back() == '/') {
+        return directory + name;
+    }
+    return directory + "/" + name;
+}
+
+bool is_under(const std::string& path, const std::string& directory) {
+    return path.size() >= directory.size() && path.compare(0, directory.size(), directory) == 0 &&
+           (path.size() == directory.size() || path[directory.size()] == '/');
+}
+
+}
+
+DirectoryWatcher::DirectoryWatcher(std::chrono::milliseconds debounce)
+    : inotify_fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)), stop_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      debounce_(debounce), stopped_(false) {
+    if (inotify_fd_ < 0 || stop_fd_ < 0) {
+        LOG_ERROR("Cannot set up file watching: {}", std::strerror(errno));
+    }
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+    if (stop_fd_ >= 0) {
+        ::close(stop_fd_);
+    }
+}
+
+void DirectoryWatcher::ignore(const std::string& directory) {
+    std::error_code ec;
+    ignored_.push_back(fs::weakly_canonical(directory, ec).string());
+}
+
+bool DirectoryWatcher::watch(const std::string& root) {
+    if (inotify_fd_ < 0 || stop_fd_ < 0) {
+        return false;
+    }
+    
+    root_ = root;
+    struct stat st;
+    if (stat(root.c_str(), &st) != 0) {
+        LOG_ERROR("Cannot watch {}: {}", root, std::strerror(errno));
+        return false;
+    }
+    
+    if (S_ISREG(st.st_mode)) {
+        only_file_ = fs::path(root).filename().string();
+        std::string parent = fs::path(root).parent_path().string();
+        int wd = inotify_add_watch(inotify_fd_, parent.empty() ? "." : parent.c_str(), kWatchMask);
+        if (wd < 0) {
+            LOG_ERROR("Cannot watch {}: {}", root, std::strerror(errno));
+            return false;
+        }
+        directories_[wd] = parent;
+        return true;
+    }
+    
+    if (is_ignored(root)) {
+        LOG_ERROR("Cannot watch {}: it is inside the output directory", root);
+        return false;
+    }
+    add_tree(root, false);
+    return !directories_.empty();
+}
+
+bool DirectoryWatcher::wait(std::vector<std::string>& changed, std::chrono::milliseconds timeout) {
+    if (stopped_) {
+        return false;
+    }
+    
+    Clock::time_point give_up = timeout.count() < 0 ? Clock::time_point::max() : Clock::now() + timeout;
+    size_t reported = changed.size();
+    
+    while (true) {
+        Clock::time_point now = Clock::now();
+        take_settled(changed, now);
+        if (changed.size() > reported || now >= give_up) {
+            return true;
+        }
+        
+        // Sleep until the next pending file settles or the timeout runs out.
+        Clock::time_point wake = give_up;
+        for (const auto& [path, changed_at] : pending_) {
+            wake = std::min(wake, changed_at + debounce_);
+        }
+        int wait_ms = -1;
+        if (wake != Clock::time_point::max()) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(wake - now);
+            wait_ms = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+        }
+        
+        struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+        int ready = poll(fds, 2, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            LOG_ERROR("Waiting for file events failed: {}", std::strerror(errno));
+            stopped_ = true;
+            return false;
+        }
+        if (ready > 0 && (fds[1].revents & POLLIN)) {
+            stopped_ = true;
+            return false;
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN) && !read_events()) {
+            stopped_ = true;
+            return false;
+        }
+    }
+}
+
+void DirectoryWatcher::stop() {
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = ::write(stop_fd_, &one, sizeof(one));
+}
+
+size_t DirectoryWatcher::directories() const {
+    return directories_.size();
+}
+
+bool DirectoryWatcher::is_ignored(const std::string& directory) const {
+    if (ignored_.empty()) {
+        return false;
+    }
+    
+    std::error_code ec;
+    std::string canonical = fs::weakly_canonical(directory, ec).string();
+    for (const auto& ignored : ignored_) {
+        if (is_under(canonical, ignored)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Watches are added before listing the directory, so a file created in
+// between is seen either by the listing or by an event.
+void DirectoryWatcher::add_tree(const std::string& directory, bool report_files) {
+    int wd = inotify_add_watch(inotify_fd_, directory.c_str(), kWatchMask);
+    if (wd < 0) {
+        if (errno == ENOSPC) {
+            LOG_WARNING("Cannot watch {}: inotify watch limit reached "
+                        "(raise fs.inotify.max_user_watches)", directory);
+        } else if (errno != ENOENT && errno != ENOTDIR) {
+            LOG_WARNING("Cannot watch {}: {}", directory, std::strerror(errno));
+        }
+        return;
+    }
+    directories_[wd] = directory;
+    
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+    
+    Clock::time_point now = Clock::now();
+    int dir_fd = dirfd(dir);
+    while (struct dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+        
+        std::string path = join_path(directory, name);
+        if (type == DT_DIR) {
+            if (!is_ignored(path)) {
+                add_tree(path, report_files);
+            }
+        } else if (report_files && type == DT_REG) {
+            pending_[std::move(path)] = now;
+        }
+    }
+    
+    closedir(dir);
+}
+
+// Stops watching a directory that was moved away, since its events would
+// otherwise arrive under its old path.
+void DirectoryWatcher::remove_tree(const std::string& directory) {
+    for (auto it = directories_.begin(); it != directories_.end();) {
+        if (is_under(it->second, directory)) {
+            inotify_rm_watch(inotify_fd_, it->first);
+            it = directories_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        it = is_under(it->first, directory) ? pending_.erase(it) : std::next(it);
+    }
+}
+
+bool DirectoryWatcher::read_events() {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    
+    while (true) {
+        ssize_t length = ::read(inotify_fd_, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EAGAIN) {
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Reading file events failed: {}", std::strerror(errno));
+            return false;
+        }
+        
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            handle_event(event->wd, event->mask, event->len > 0 ? event->name : "");
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+void DirectoryWatcher::handle_event(int wd, uint32_t mask, const char* name) {
+    if (mask & IN_Q_OVERFLOW) {
+        LOG_WARNING("File events were dropped; rescanning {}", root_);
+        if (only_file_.empty()) {
+            add_tree(root_, true);
+        } else {
+            pending_[root_] = Clock::now();
+        }
+        return;
+    }
+    if (mask & IN_IGNORED) {
+        directories_.erase(wd);
+        return;
+    }
+    
+    auto directory = directories_.find(wd);
+    if (directory == directories_.end() || name[0] == '\0') {
+        return;
+    }
+    
+    if (!only_file_.empty()) {
+        if (only_file_ != name || (mask & IN_ISDIR)) {
+            return;
+        }
+        if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+            pending_.erase(root_);
+        } else {
+            pending_[root_] = Clock::now();
+        }
+        return;
+    }
+    
+    std::string path = join_path(directory->second, name);
+    if (mask & IN_ISDIR) {
+        if (mask & IN_MOVED_FROM) {
+            remove_tree(path);
+        } else if ((mask & (IN_CREATE | IN_MOVED_TO)) && !is_ignored(path)) {
+            add_tree(path, true);
+        }
+        return;
+    }
+    
+    if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+        pending_.erase(path);
+    } else {
+        pending_[std::move(path)] = Clock::now();
+    }
+}
+
+void DirectoryWatcher::take_settled(std::vector<std::string>& changed, Clock::time_point now) {
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (now - it->second >= debounce_) {
+            changed.push_back(it->first);
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../../include/common.h"
+
+// Watches a directory tree through inotify and reports the regular files
+// that were written, created or moved into it. Events for one file are
+// merged and the file is reported once it has been quiet for the debounce
+// interval, so a file written in many chunks is reported once, after its
+// last write. Directories created or moved in later are watched as they
+// appear and the files already inside them are reported too. If the
+// kernel drops events, every file under the root is reported again.
+//
+// Deleted files are not reported. Only the thread calling wait() may use
+// the watcher, except for stop().
+class DirectoryWatcher {
+public:
+    explicit DirectoryWatcher(std::chrono::milliseconds debounce);
+    ~DirectoryWatcher();
+    
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+    
+    // Leaves directory and everything below it unwatched, e.g. an output
+    // directory inside the watched tree. Call before watch().
+    void ignore(const std::string& directory);
+    
+    // Starts watching root, a directory or a single file. Call once.
+    bool watch(const std::string& root);
+    
+    // Blocks until at least one file has settled, then appends every
+    // settled file to changed. Returns true early with nothing appended
+    // when timeout runs out, and false once stop() has been called. A
+    // negative timeout waits indefinitely.
+    bool wait(std::vector<std::string>& changed,
+              std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+    
+    // Wakes up wait() for good. Safe to call from another thread or from a
+    // signal handler.
+    void stop();
+    
+    size_t directories() const;
+    
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    int inotify_fd_;
+    int stop_fd_;
+    std::chrono::milliseconds debounce_;
+    std::string root_;
+    // Set when root_ is a single file; its parent directory is watched.
+    std::string only_file_;
+    std::vector<std::string> ignored_;
+    std::unordered_map<int, std::string> directories_;
+    // Files with unreported events and when they last changed.
+    std::unordered_map<std::string, Clock::time_point> pending_;
+    bool stopped_;
+    
+    bool is_ignored(const std::string& directory) const;
+    void add_tree(const std::string& directory, bool report_files);
+    void remove_tree(const std::string& directory);
+    bool read_events();
+    void handle_event(int wd, uint32_t mask, const char* name);
+    void take_settled(std::vector<std::string>& changed, Clock::time_point now);
+};
@@ -0,0 +1,37 @@
+#include "FileBatcher.h"
+
+FileBatcher::FileBatcher(size_t max_bytes, size_t max_files, Sink sink)
+    : max_bytes_(max_bytes), max_files_(std::max<size_t>(max_files, 1)), sink_(std::move(sink)),
+      batch_bytes_(0), batches_sent_(0) {}
+
+void FileBatcher::add(std::string path, size_t size) {
+    if (max_bytes_ == 0 || size >= max_bytes_) {
+        ++batches_sent_;
+        sink_({std::move(path)}, size);
+        return;
+    }
+    
+    if (batch_bytes_ + size > max_bytes_ || batch_.size() >= max_files_) {
+        flush();
+    }
+    
+    batch_.push_back(std::move(path));
+    batch_bytes_ += size;
+}
+
+void FileBatcher::flush() {
+    if (batch_.empty()) {
+        return;
+    }
+    
+    std::vector<std::string> batch;
+    batch.swap(batch_);
+    size_t bytes = batch_bytes_;
+    batch_bytes_ = 0;
+    ++batches_sent_;
+    sink_(std::move(batch), bytes);
+}
+
+size_t FileBatcher::batches_sent() const {
+    return batches_sent_;
+}
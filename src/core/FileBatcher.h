@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../include/common.h"
+
+// Groups small files into batches so a corpus of tiny files costs one
+// pool task per batch instead of one per file. A file of at least
+// max_bytes is never batched and goes out alone. A batch is handed to
+// the sink when the next file would push it past max_bytes or it already
+// holds max_files; flush() sends whatever is left. max_bytes == 0
+// disables batching.
+class FileBatcher {
+public:
+    // Receives the files of one task and their total size.
+    using Sink = std::function<void(std::vector<std::string>, size_t)>;
+    
+    FileBatcher(size_t max_bytes, size_t max_files, Sink sink);
+    
+    void add(std::string path, size_t size);
+    void flush();
+    
+    // Every call of the sink, including files sent alone.
+    size_t batches_sent() const;
+    
+private:
+    size_t max_bytes_;
+    size_t max_files_;
+    Sink sink_;
+    std::vector<std::string> batch_;
+    size_t batch_bytes_;
+    size_t batches_sent_;
+};
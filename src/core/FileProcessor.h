@@ -2,28 +2,82 @@
 
 #include "../../include/common.h"
 #include "../observers/Observer.h"
+#include "../utils/Timer.h"
+#include "../utils/ContentHash.h"
+#include "InputFile.h"
+#include "ReportWriter.h"
+
+// Creates path once per process; later calls for the same directory skip
+// the filesystem. Reports are written through ReportWriter::write_file(),
+// which recreates a directory that disappeared after it was cached.
+inline void ensure_directory(const std::string& path) {
+    static std::mutex mutex;
+    static std::unordered_set<std::string> created;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    if (created.count(path) == 0) {
+        fs::create_directories(path);
+        created.insert(path);
+    }
+}
 
 class IFileProcessor {
 public:
     virtual ~IFileProcessor() = default;
     virtual ProcessResult process(const std::string& filepath) = 0;
+    
+    // Same as process() for a file whose contents were already read, e.g.
+    // by a ReadEngine.
+    virtual ProcessResult process_contents(const std::string& filepath, std::string_view contents) = 0;
+    
+    // Result for a file whose contents are identical to original's input:
+    // original's report is copied to filepath's report instead of
+    // analyzing the file again.
+    virtual ProcessResult share_result(const std::string& filepath, const ProcessResult& original) = 0;
     virtual bool canProcess(const std::string& extension) const = 0;
     virtual std::string getProcessorName() const = 0;
+    virtual void attach_progress_observer(std::shared_ptr<Observer<ProgressEvent>> observer) = 0;
+    virtual void set_input_mode(InputMode mode) = 0;
+    
+    // Reports go through writer when set; otherwise each is written before
+    // process() returns.
+    virtual void set_report_writer(ReportWriter* writer) = 0;
+    
+    // When enabled, a successful result carries the XXH64 of the bytes
+    // that were analyzed in metadata["content_hash"] (decimal), computed
+    // while analyzing.
+    virtual void set_content_hashing(bool enabled) = 0;
 };
 
+// Identifies a file in progress events; unique within the process.
+inline uint64_t next_progress_file_id() {
+    static std::atomic<uint64_t> next_id{0};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
 template<typename Derived>
 class FileProcessor : public IFileProcessor {
 protected:
     Subject<ProgressEvent> progress_subject_;
     std::string output_directory_;
+    InputMode input_mode_;
+    ReportWriter* report_writer_;
+    bool hash_contents_;
+    ContentHasher content_hasher_;
     
+    // The file being processed and the bytes its reporters already sent.
+    uint64_t progress_file_id_;
+    uint64_t progress_total_bytes_;
+    std::atomic<uint64_t> progress_reported_bytes_;
+
 public:
     explicit FileProcessor(const std::string& output_dir = "./output") 
-        : output_directory_(output_dir) {
-        fs::create_directories(output_directory_);
+        : output_directory_(output_dir), input_mode_(InputMode::BUFFERED), report_writer_(nullptr),
+          hash_contents_(false), progress_file_id_(0), progress_total_bytes_(0), progress_reported_bytes_(0) {
+        ensure_directory(output_directory_);
     }
     
-    void attach_progress_observer(std::shared_ptr<Observer<ProgressEvent>> observer) {
+    void attach_progress_observer(std::shared_ptr<Observer<ProgressEvent>> observer) override {
         progress_subject_.attach(observer);
     }
     
@@ -31,11 +85,29 @@ public:
         progress_subject_.detach(observer);
     }
     
+    void set_input_mode(InputMode mode) override {
+        input_mode_ = mode;
+    }
+    
+    InputMode input_mode() const {
+        return input_mode_;
+    }
+    
+    void set_report_writer(ReportWriter* writer) override {
+        report_writer_ = writer;
+    }
+    
+    void set_content_hashing(bool enabled) override {
+        hash_contents_ = enabled;
+    }
+    
     ProcessResult process(const std::string& filepath) override {
         ProcessResult result;
+        result.input_path = filepath;
         Timer timer;
         timer.start();
         
+        bool started = false;
         try {
             if (!fs::exists(filepath)) {
                 result.message = "File does not exist: " + filepath;
@@ -43,17 +115,56 @@ public:
             }
             
             size_t file_size = fs::file_size(filepath);
-            progress_subject_.notify_all(ProgressEvent(filepath, 0, file_size, "started"));
+            begin_progress(file_size);
+            started = true;
+            content_hasher_.reset();
             
             result = static_cast<Derived*>(this)->process_impl(filepath);
+            result.input_path = filepath;
+            add_content_hash(result);
             result.bytes_processed = file_size;
             
             timer.stop();
             result.processing_time = timer.elapsed_milliseconds();
+        
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Processing failed: " + std::string(e.what());
+            timer.stop();
+            result.processing_time = timer.elapsed_milliseconds();
+        }
+        
+        // Observers saw the file start, so they hear how it ended even
+        // when the processor threw.
+        if (started) {
+            end_progress(filepath, result);
+        }
+        return result;
+    }
+    
+    ProcessResult process_contents(const std::string& filepath, std::string_view contents) override {
+        ProcessResult result;
+        result.input_path = filepath;
+        Timer timer;
+        timer.start();
+        
+        bool started = false;
+        try {
+            begin_progress(contents.size());
+            started = true;
+            content_hasher_.reset();
+            if (hash_contents_) {
+                content_hasher_.update(contents);
+            }
             
-            std::string status = result.success ? "completed" : "failed";
-            progress_subject_.notify_all(ProgressEvent(filepath, file_size, file_size, status));
+            result = static_cast<Derived*>(this)->process_contents_impl(filepath, contents);
+            result.input_path = filepath;
+            add_content_hash(result);
+            result.bytes_processed = contents.size();
             
+            timer.stop();
+            result.processing_time = timer.elapsed_milliseconds();
+        
         } catch (const std::exception& e) {
             result.success = false;
             result.message = "Processing failed: " + std::string(e.what());
@@ -61,12 +172,80 @@ public:
             result.processing_time = timer.elapsed_milliseconds();
         }
         
+        if (started) {
+            end_progress(filepath, result);
+        }
         return result;
     }
     
+    ProcessResult share_result(const std::string& filepath, const ProcessResult& original) override {
+        ProcessResult result = original;
+        result.input_path = filepath;
+        result.processing_time = std::chrono::milliseconds(0);
+        result.metadata["duplicate_of"] = original.input_path;
+        begin_progress(original.bytes_processed);
+        
+        // A consolidated stream gets a record pointing at the original.
+        auto report = original.metadata.find("output_file");
+        if (consolidated_reports()) {
+            std::string record = "{\"file\":";
+            append_json_string(record, filepath);
+            record += ",\"duplicate_of\":";
+            append_json_string(record, original.input_path);
+            record += "}\n";
+            report_writer_->append(std::move(record));
+        } else if (report != original.metadata.end()) {
+            std::string output_path = static_cast<Derived*>(this)->report_path(filepath);
+            std::error_code ec;
+            if (output_path != report->second && report_writer_) {
+                report_writer_->copy(report->second, output_path);
+            } else if (output_path != report->second) {
+                fs::copy_file(report->second, output_path, fs::copy_options::overwrite_existing, ec);
+            }
+            if (ec) {
+                result.success = false;
+                result.message = "Cannot copy report for duplicate: " + output_path + " (" + ec.message() + ")";
+            }
+            result.metadata["output_file"] = output_path;
+        }
+        
+        end_progress(filepath, result);
+        return result;
+    }
+
 protected:
-    void notify_progress(const std::string& filepath, size_t processed, size_t total, const std::string& status) {
-        progress_subject_.notify_all(ProgressEvent(filepath, processed, total, status));
+    // Opens filepath with the configured input mode. Derived processors
+    // read through InputFile::view() or for_each_chunk() rather than
+    // opening streams themselves.
+    bool open_input(const std::string& filepath, InputFile& input) const {
+        return input.open(filepath, input_mode_);
+    }
+    
+    // The hasher process_impl() feeds every byte it analyzes, in file
+    // order, or nullptr when content hashing is off.
+    ContentHasher* content_hasher() {
+        return hash_contents_ ? &content_hasher_ : nullptr;
+    }
+    
+    bool consolidated_reports() const {
+        return report_writer_ && report_writer_->format() == ReportFormat::NDJSON;
+    }
+    
+    // Hands a finished report to the report writer, or writes it now if
+    // there is none. Only the synchronous path can report a failure.
+    bool write_report(const std::string& path, std::string contents) {
+        if (report_writer_) {
+            report_writer_->write(path, std::move(contents));
+            return true;
+        }
+        return ReportWriter::write_file(path, contents);
+    }
+    
+    // A throttled reporter for the file being processed. Call it once per
+    // thread that reads the file, and only from within process_impl().
+    ProgressReporter progress_reporter() {
+        return ProgressReporter(progress_subject_, progress_file_id_, progress_total_bytes_,
+                                progress_reported_bytes_);
     }
     
     std::string get_output_path(const std::string& input_path, const std::string& suffix = "") const {
@@ -74,4 +253,27 @@ protected:
         std::string filename = input.stem().string() + suffix + input.extension().string();
         return (fs::path(output_directory_) / filename).string();
     }
+
+private:
+    void add_content_hash(ProcessResult& result) const {
+        if (hash_contents_ && result.success) {
+            result.metadata["content_hash"] = std::to_string(content_hasher_.digest());
+        }
+    }
+    
+    void begin_progress(uint64_t total_bytes) {
+        progress_file_id_ = next_progress_file_id();
+        progress_total_bytes_ = total_bytes;
+        progress_reported_bytes_.store(0, std::memory_order_relaxed);
+        progress_subject_.notify_all(ProgressEvent{progress_file_id_, 0, total_bytes, ProgressStatus::STARTED});
+    }
+    
+    void end_progress(const std::string& filepath, const ProcessResult& result) {
+        uint64_t reported = progress_reported_bytes_.load(std::memory_order_relaxed);
+        uint64_t remaining = progress_total_bytes_ > reported ? progress_total_bytes_ - reported : 0;
+        progress_subject_.notify_all(ProgressEvent{progress_file_id_, remaining, progress_total_bytes_,
+            result.success ? ProgressStatus::COMPLETED : ProgressStatus::FAILED});
+        LOG_DEBUG("Processed {} ({} bytes, {} ms)", filepath, progress_total_bytes_,
+                  result.processing_time.count());
+    }
 };
\ No newline at end of file
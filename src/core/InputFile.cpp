@@ -0,0 +1,189 @@
+#include "InputFile.h"
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+InputFile::InputFile() : fd_(-1), mapping_(nullptr), size_(0), regular_(false) {}
+
+InputFile::~InputFile() {
+    close();
+}
+
+bool InputFile::open(const std::string& filepath, InputMode mode) {
+    close();
+    
+    fd_ = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        error_ = std::strerror(errno);
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd_, &info) != 0) {
+        error_ = std::strerror(errno);
+        close();
+        return false;
+    }
+    
+    regular_ = S_ISREG(info.st_mode);
+    size_ = regular_ ? static_cast<size_t>(info.st_size) : 0;
+    
+    if (mode == InputMode::MMAP && regular_ && size_ > 0) {
+        map_file();
+    } else if (regular_) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    
+    return true;
+}
+
+bool InputFile::map_file() {
+    // Leave half the address-space limit for everything else; mapping a
+    // file bigger than that is what makes later allocations fail.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_AS, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+        size_ > limit.rlim_cur / 2) {
+        return false;
+    }
+    
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+    madvise(mapping, size_, MADV_WILLNEED);
+    mapping_ = mapping;
+    return true;
+}
+
+void InputFile::close() {
+    if (mapping_) {
+        munmap(mapping_, size_);
+        mapping_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    regular_ = false;
+}
+
+bool InputFile::is_mapped() const {
+    return mapping_ != nullptr;
+}
+
+size_t InputFile::size() const {
+    return size_;
+}
+
+const std::string& InputFile::error() const {
+    return error_;
+}
+
+std::string_view InputFile::view() const {
+    if (!mapping_) {
+        return {};
+    }
+    return std::string_view(static_cast<const char*>(mapping_), size_);
+}
+
+bool InputFile::for_each_chunk(size_t chunk_size, std::vector<char>& buffer,
+                               const std::function<void(std::string_view)>& handler) {
+    if (fd_ < 0) {
+        error_ = "File is not open";
+        return false;
+    }
+    
+    if (!read_range(0, std::numeric_limits<size_t>::max(), chunk_size, buffer, handler)) {
+        error_ = std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool InputFile::read_range(size_t offset, size_t length, size_t chunk_size, std::vector<char>& buffer,
+                           const std::function<void(std::string_view)>& handler) const {
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    
+    if (mapping_) {
+        std::string_view content = view();
+        if (offset >= content.size()) {
+            return true;
+        }
+        content = content.substr(offset, length);
+        for (size_t position = 0; position < content.size(); position += chunk_size) {
+            handler(content.substr(position, chunk_size));
+        }
+        return true;
+    }
+    
+    if (fd_ < 0) {
+        errno = EBADF;
+        return false;
+    }
+    
+    buffer.resize(chunk_size);
+    size_t remaining = length;
+    off_t position = static_cast<off_t>(offset);
+    bool seekable = regular_;
+    
+    while (remaining > 0) {
+        size_t wanted = std::min(chunk_size, remaining);
+        ssize_t count = seekable ? pread(fd_, buffer.data(), wanted, position)
+                                 : read(fd_, buffer.data(), wanted);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ESPIPE && seekable && offset == 0) {
+                seekable = false;
+                continue;
+            }
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+        
+        position += count;
+        remaining -= static_cast<size_t>(count);
+        handler(std::string_view(buffer.data(), static_cast<size_t>(count)));
+    }
+    return true;
+}
+
+size_t InputFile::next_line_start(size_t offset) const {
+    if (offset == 0 || offset >= size_) {
+        return std::min(offset, size_);
+    }
+    
+    if (mapping_) {
+        size_t newline = view().find('\n', offset - 1);
+        return newline == std::string_view::npos ? size_ : newline + 1;
+    }
+    
+    char block[4096];
+    off_t position = static_cast<off_t>(offset - 1);
+    while (static_cast<size_t>(position) < size_) {
+        ssize_t count = pread(fd_, block, sizeof(block), position);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        const void* newline = std::memchr(block, '\n', static_cast<size_t>(count));
+        if (newline) {
+            return static_cast<size_t>(position) + (static_cast<const char*>(newline) - block) + 1;
+        }
+        position += count;
+    }
+    return size_;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../../include/common.h"
+
+// Read-only view of an input file. In MMAP mode regular files are mapped
+// once and handed out as zero-copy string_views; special files, empty
+// files and files that do not fit the address space fall back to
+// buffered pread() into a caller-owned buffer.
+class InputFile {
+private:
+    int fd_;
+    void* mapping_;
+    size_t size_;
+    bool regular_;
+    std::string error_;
+    
+public:
+    InputFile();
+    ~InputFile();
+    
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    
+    bool open(const std::string& filepath, InputMode mode);
+    void close();
+    
+    bool is_mapped() const;
+    size_t size() const;
+    const std::string& error() const;
+    
+    // Whole file; only available when is_mapped().
+    std::string_view view() const;
+    
+    // Feeds the file to handler in consecutive slices of at most chunk_size
+    // bytes. Mapped files are sliced in place; otherwise each slice is read
+    // into buffer, which is grown to chunk_size and reused across calls.
+    bool for_each_chunk(size_t chunk_size, std::vector<char>& buffer,
+                        const std::function<void(std::string_view)>& handler);
+    
+    // Same as for_each_chunk() restricted to [offset, offset + length).
+    // Safe to call from several threads at once with separate buffers;
+    // on failure errno describes the error.
+    bool read_range(size_t offset, size_t length, size_t chunk_size, std::vector<char>& buffer,
+                    const std::function<void(std::string_view)>& handler) const;
+    
+    // Smallest position >= offset that starts a line (0, size(), or just
+    // after a '\n'). Only meaningful for regular files.
+    size_t next_line_start(size_t offset) const;
+    
+private:
+    bool map_file();
+};
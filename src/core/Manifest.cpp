@@ -0,0 +1,256 @@
+#include "Manifest.h"
+#include "InputFile.h"
+#include "../utils/ContentHash.h"
+#include "../utils/Logger.h"
+#include <charconv>
+
+namespace {
+
+constexpr const char* kFormatTag = "file_processor-manifest 1";
+constexpr size_t kFixedFields = 7;
+
+// Fields are tab-separated and records newline-separated, so those two
+// and the escape character itself are escaped inside fields.
+void append_escaped(std::string& out, std::string_view field) {
+    for (char c : field) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            default: out += c; break;
+        }
+    }
+}
+
+std::vector<std::string> split_fields(const std::string& line) {
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (c == '\t') {
+            fields.emplace_back();
+        } else if (c == '\\' && i + 1 < line.size()) {
+            char escaped = line[++i];
+            fields.back() += escaped == 't' ? '\t' : escaped == 'n' ? '\n' : escaped;
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+}
+
+Manifest::Manifest(std::string path, std::string settings, bool hash_contents)
+    : path_(std::move(path)), settings_(std::move(settings)), hash_contents_(hash_contents) {}
+
+bool Manifest::load() {
+    records_.clear();
+    
+    std::ifstream in(path_);
+    if (!in.is_open()) {
+        return false;
+    }
+    
+    std::string line;
+    if (!std::getline(in, line)) {
+        return false;
+    }
+    std::vector<std::string> header = split_fields(line);
+    if (header.size() != 2 || header[0] != kFormatTag || header[1] != settings_) {
+        LOG_INFO("Manifest {} was written with other settings; processing every file", path_);
+        return false;
+    }
+    
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields = split_fields(line);
+        if (fields.size() < kFixedFields) {
+            continue;
+        }
+        
+        try {
+            Record record;
+            record.state.size = std::stoull(fields[1]);
+            record.state.mtime_ns = std::stoll(fields[2]);
+            record.state.device = std::stoull(fields[3]);
+            record.state.inode = std::stoull(fields[4]);
+            record.state.hashed = fields[5] != "-";
+            record.state.content_hash = record.state.hashed ? std::stoull(fields[5], nullptr, 16) : 0;
+            
+            record.result.success = true;
+            record.result.input_path = fields[0];
+            record.result.message = fields[6];
+            record.result.bytes_processed = record.state.size;
+            for (size_t i = kFixedFields; i < fields.size(); ++i) {
+                size_t separator = fields[i].find('=');
+                if (separator != std::string::npos) {
+                    record.result.metadata[fields[i].substr(0, separator)] = fields[i].substr(separator + 1);
+                }
+            }
+            record.valid = true;
+            records_[fields[0]] = std::move(record);
+        } catch (const std::exception&) {
+            // A damaged line only costs reprocessing that file.
+        }
+    }
+    
+    return true;
+}
+
+bool Manifest::save() const {
+    std::string out;
+    out.reserve(64 + records_.size() * 160);
+    out += kFormatTag;
+    out += '\t';
+    append_escaped(out, settings_);
+    out += '\n';
+    
+    char hash[17];
+    for (const auto& [filepath, record] : records_) {
+        if (!record.seen || !record.valid) {
+            continue;
+        }
+        
+        const FileState& state = record.state;
+        append_escaped(out, filepath);
+        out += '\t';
+        out += std::to_string(state.size);
+        out += '\t';
+        out += std::to_string(state.mtime_ns);
+        out += '\t';
+        out += std::to_string(state.device);
+        out += '\t';
+        out += std::to_string(state.inode);
+        out += '\t';
+        if (state.hashed) {
+            std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(state.content_hash));
+            out += hash;
+        } else {
+            out += '-';
+        }
+        out += '\t';
+        append_escaped(out, record.result.message);
+        for (const auto& [key, value] : record.result.metadata) {
+            out += '\t';
+            append_escaped(out, key);
+            out += '=';
+            append_escaped(out, value);
+        }
+        out += '\n';
+    }
+    
+    std::string temporary = path_ + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("Cannot write manifest: {}", temporary);
+            return false;
+        }
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file) {
+            LOG_ERROR("Cannot write manifest: {}", temporary);
+            return false;
+        }
+    }
+    
+    std::error_code ec;
+    fs::rename(temporary, path_, ec);
+    if (ec) {
+        LOG_ERROR("Cannot replace manifest {}: {}", path_, ec.message());
+        return false;
+    }
+    return true;
+}
+
+bool Manifest::reuse(const std::string& filepath, const FileState& state, ProcessResult& previous) {
+    Record& record = records_[filepath];
+    record.seen = true;
+    
+    if (record.valid && unchanged(record, filepath, state)) {
+        previous = record.result;
+        previous.input_path = filepath;
+        return true;
+    }
+    
+    record.valid = false;
+    record.state = state;
+    return false;
+}
+
+bool Manifest::unchanged(Record& record, const std::string& filepath, const FileState& state) const {
+    const FileState& known = record.state;
+    if (known.size != state.size) {
+        return false;
+    }
+    
+    // A report that was deleted has to be produced again.
+    auto output = record.result.metadata.find("output_file");
+    std::error_code ec;
+    if (output != record.result.metadata.end() && !fs::exists(output->second, ec)) {
+        return false;
+    }
+    
+    if (known.mtime_ns == state.mtime_ns && known.device == state.device && known.inode == state.inode) {
+        // Records written without hashing get their hash on first use.
+        if (hash_contents_ && !known.hashed) {
+            record.state.hashed = hash_file(filepath, record.state.content_hash);
+        }
+        return true;
+    }
+    
+    uint64_t hash = 0;
+    if (!hash_contents_ || !known.hashed || !hash_file(filepath, hash) || hash != known.content_hash) {
+        return false;
+    }
+    
+    record.state = state;
+    record.state.content_hash = hash;
+    record.state.hashed = true;
+    return true;
+}
+
+void Manifest::record(const ProcessResult& result) {
+    auto it = records_.find(result.input_path);
+    if (it == records_.end()) {
+        return;
+    }
+    
+    Record& record = it->second;
+    record.valid = result.success;
+    if (!result.success) {
+        return;
+    }
+    
+    record.result = result;
+    record.result.processing_time = std::chrono::milliseconds(0);
+    record.state.hashed = false;
+    
+    auto hash = result.metadata.find("content_hash");
+    if (hash_contents_ && hash != result.metadata.end()) {
+        const std::string& digits = hash->second;
+        auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), record.state.content_hash);
+        record.state.hashed = ec == std::errc() && end == digits.data() + digits.size();
+    }
+}
+
+const std::string& Manifest::path() const {
+    return path_;
+}
+
+size_t Manifest::size() const {
+    return records_.size();
+}
+
+bool Manifest::hash_file(const std::string& filepath, uint64_t& hash) {
+    InputFile input;
+    if (!input.open(filepath, InputMode::MMAP)) {
+        return false;
+    }
+    
+    ContentHasher hasher;
+    std::vector<char> buffer;
+    if (!input.for_each_chunk(1 << 20, buffer, [&hasher](std::string_view chunk) { hasher.update(chunk); })) {
+        return false;
+    }
+    hash = hasher.digest();
+    return true;
+}
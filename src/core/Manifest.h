@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../../include/common.h"
+
+// Remembers, per input path, what the file looked like when it was last
+// processed successfully and the result that run produced, so the next
+// run over the same tree can skip files that have not changed.
+//
+// A file counts as unchanged when its size, mtime, device and inode all
+// match and the report it produced still exists. With content hashing on,
+// a file whose size matches but whose mtime or inode moved (a touch, a
+// copy, a restore from backup) is hashed and still skipped if its
+// contents are the same. Processed files are hashed by the worker that
+// analyzes them (IFileProcessor::set_content_hashing()), so record() only
+// reads the hash from the result. The manifest is tied to a settings
+// string; when the settings differ every file is processed again.
+//
+// Not thread-safe: the thread that submits files and collects results
+// owns it.
+class Manifest {
+public:
+    struct FileState {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        uint64_t content_hash = 0;
+        bool hashed = false;
+    };
+    
+    Manifest(std::string path, std::string settings, bool hash_contents);
+    
+    // Reads the manifest left by the previous run. Returns false, leaving
+    // the manifest empty, when there is none or it does not apply.
+    bool load();
+    
+    // Writes the records of every file seen in this run, replacing the old
+    // manifest atomically. Files that disappeared since are dropped.
+    bool save() const;
+    
+    // Returns true and the previous result if filepath is unchanged.
+    // Otherwise remembers state so record() can store the new result.
+    bool reuse(const std::string& filepath, const FileState& state, ProcessResult& previous);
+    
+    // Stores a successful result for the next run; a failed one is dropped
+    // so the file is retried. With content hashing on, the hash comes from
+    // metadata["content_hash"]; a result without one is stored unhashed.
+    void record(const ProcessResult& result);
+    
+    const std::string& path() const;
+    size_t size() const;
+    
+    static bool hash_file(const std::string& filepath, uint64_t& hash);
+    
+private:
+    struct Record {
+        FileState state;
+        ProcessResult result;
+        bool seen = false;
+        bool valid = false;
+    };
+    
+    std::string path_;
+    std::string settings_;
+    bool hash_contents_;
+    std::unordered_map<std::string, Record> records_;
+    
+    bool unchanged(Record& record, const std::string& filepath, const FileState& state) const;
+};
@@ -0,0 +1,40 @@
+#include "ProcessorPool.h"
+
+ProcessorPool::Lease::Lease(ProcessorPool& pool, std::unique_ptr<IFileProcessor> processor)
+    : pool_(&pool), processor_(std::move(processor)) {}
+
+ProcessorPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), processor_(std::move(other.processor_)) {}
+
+ProcessorPool::Lease::~Lease() {
+    if (processor_) {
+        pool_->release(std::move(processor_));
+    }
+}
+
+ProcessorPool::ProcessorPool(Factory factory) : factory_(std::move(factory)), created_(0) {}
+
+ProcessorPool::Lease ProcessorPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            std::unique_ptr<IFileProcessor> processor = std::move(idle_.back());
+            idle_.pop_back();
+            return Lease(*this, std::move(processor));
+        }
+        ++created_;
+    }
+    
+    // Built outside the lock: construction may touch the filesystem.
+    return Lease(*this, factory_());
+}
+
+size_t ProcessorPool::created() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return created_;
+}
+
+void ProcessorPool::release(std::unique_ptr<IFileProcessor> processor) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(std::move(processor));
+}
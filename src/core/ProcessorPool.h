@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../include/common.h"
+#include "FileProcessor.h"
+
+// Hands out long-lived processors so per-file work reuses their buffers
+// and tables instead of constructing a processor per file. acquire()
+// takes an idle processor or builds one with the factory; the lease gives
+// it back when destroyed. A task that runs another task while waiting
+// (ThreadPool::help_until_ready) simply holds two leases, so no processor
+// is ever used by two files at once.
+class ProcessorPool {
+public:
+    using Factory = std::function<std::unique_ptr<IFileProcessor>()>;
+    
+    class Lease {
+    public:
+        Lease(ProcessorPool& pool, std::unique_ptr<IFileProcessor> processor);
+        ~Lease();
+        
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+        
+        IFileProcessor* operator->() const { return processor_.get(); }
+        IFileProcessor& operator*() const { return *processor_; }
+        
+    private:
+        ProcessorPool* pool_;
+        std::unique_ptr<IFileProcessor> processor_;
+    };
+    
+    explicit ProcessorPool(Factory factory);
+    
+    Lease acquire();
+    
+    // Number of processors the factory has built so far.
+    size_t created() const;
+    
+private:
+    void release(std::unique_ptr<IFileProcessor> processor);
+    
+    Factory factory_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<IFileProcessor>> idle_;
+    size_t created_;
+};
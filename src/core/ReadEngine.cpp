@@ -0,0 +1,494 @@
+#include "ReadEngine.h"
+#include "ThreadPool.h"
+#include "../utils/Logger.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+ReadBuffer::ReadBuffer(std::unique_ptr<char[]> data, size_t size, int error, ReadEngine* owner, size_t accounted)
+    : data_(std::move(data)), size_(size), error_(error), owner_(owner), accounted_(accounted) {}
+
+ReadBuffer::~ReadBuffer() {
+    release();
+}
+
+ReadBuffer::ReadBuffer(ReadBuffer&& other) noexcept
+    : data_(std::move(other.data_)), size_(other.size_), error_(other.error_), owner_(other.owner_),
+      accounted_(other.accounted_) {
+    other.owner_ = nullptr;
+}
+
+ReadBuffer& ReadBuffer::operator=(ReadBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::move(other.data_);
+        size_ = other.size_;
+        error_ = other.error_;
+        owner_ = other.owner_;
+        accounted_ = other.accounted_;
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+void ReadBuffer::release() {
+    if (owner_) {
+        owner_->release_buffer(accounted_);
+        owner_ = nullptr;
+    }
+}
+
+ReadEngine::ReadEngine(size_t queue_depth, size_t max_buffered_bytes)
+    : queue_depth_(std::max<size_t>(queue_depth, 1)), max_buffered_bytes_(max_buffered_bytes),
+      in_flight_(0), buffered_bytes_(0) {}
+
+std::future<ReadBuffer> ReadEngine::read(const std::string& path) {
+    auto request = std::make_unique<Request>();
+    std::future<ReadBuffer> result = request->promise.get_future();
+    
+    request->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (request->fd < 0 || fstat(request->fd, &st) != 0) {
+        int error = errno;
+        if (request->fd >= 0) {
+            ::close(request->fd);
+        }
+        request->promise.set_value(ReadBuffer(nullptr, 0, error, nullptr, 0));
+        return result;
+    }
+    
+    // The stat size is what gets read; a file that grows meanwhile is
+    // truncated to it, one that shrinks ends at EOF.
+    request->size = static_cast<size_t>(st.st_size);
+    request->data = std::make_unique_for_overwrite<char[]>(request->size);
+    request->accounted = request->size;
+    
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffered_bytes_ += request->accounted;
+        
+        if (request->size == 0) {
+            lock.unlock();
+            ::close(request->fd);
+            request->promise.set_value(ReadBuffer(nullptr, 0, 0, this, 0));
+            return result;
+        }
+        
+        changed_.wait(lock, [this] { return in_flight_ < queue_depth_; });
+        ++in_flight_;
+    }
+    
+    start(std::move(request));
+    return result;
+}
+
+void ReadEngine::wait_for_buffer_space(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this, bytes] {
+        return buffered_bytes_ == 0 || buffered_bytes_ + bytes <= max_buffered_bytes_;
+    });
+}
+
+size_t ReadEngine::buffered_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffered_bytes_;
+}
+
+void ReadEngine::complete(std::unique_ptr<Request> request, int error) {
+    ::close(request->fd);
+    request->promise.set_value(
+        ReadBuffer(std::move(request->data), request->done, error, this, request->accounted));
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    --in_flight_;
+    changed_.notify_all();
+}
+
+void ReadEngine::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return in_flight_ == 0; });
+}
+
+void ReadEngine::release_buffer(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffered_bytes_ -= bytes;
+    changed_.notify_all();
+}
+
+namespace {
+
+// Blocking reads on a few threads; the fallback when io_uring is missing.
+class ThreadReadEngine : public ReadEngine {
+public:
+    ThreadReadEngine(size_t queue_depth, size_t max_buffered_bytes)
+        : ReadEngine(queue_depth, max_buffered_bytes), readers_(std::min<size_t>(queue_depth, 8)) {}
+    
+    ~ThreadReadEngine() override {
+        drain();
+    }
+    
+    const char* name() const override {
+        return "threads";
+    }
+    
+protected:
+    void start(std::unique_ptr<Request> request) override {
+        readers_.enqueue([this, request = std::move(request)]() mutable {
+            int error = 0;
+            while (request->done < request->size) {
+                ssize_t n = pread(request->fd, request->data.get() + request->done,
+                                  request->size - request->done, static_cast<off_t>(request->done));
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    error = n < 0 ? errno : 0;
+                    break;
+                }
+                request->done += static_cast<size_t>(n);
+            }
+            complete(std::move(request), error);
+        });
+    }
+    
+private:
+    ThreadPool readers_;
+};
+
+int io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// One ring shared by all reads. Submissions go in under a mutex from the
+// reading threads; a single reaper thread waits for completions, re-queues
+// short reads and fulfils the promises.
+class UringReadEngine : public ReadEngine {
+public:
+    UringReadEngine(size_t queue_depth, size_t max_buffered_bytes)
+        : ReadEngine(queue_depth, max_buffered_bytes), ring_fd_(-1), sq_ring_(MAP_FAILED),
+          cq_ring_(MAP_FAILED), sqes_(MAP_FAILED), sq_ring_size_(0), cq_ring_size_(0), sqes_size_(0),
+          sq_submitted_(0), kernel_in_flight_(0), stopping_(false), wake_failed_(false) {
+        queue_depth = std::max<size_t>(queue_depth, 1);
+        slots_.resize(queue_depth);
+        for (size_t i = queue_depth; i > 0; --i) {
+            free_slots_.push_back(i - 1);
+        }
+    }
+    
+    ~UringReadEngine() override {
+        if (reaper_.joinable()) {
+            drain();
+            {
+                std::lock_guard<std::mutex> lock(submit_mutex_);
+                stopping_ = true;
+                io_uring_sqe* sqe = next_sqe();
+                sqe->opcode = IORING_OP_NOP;
+                sqe->user_data = kWakeTag;
+                submit_locked();
+                if (wake_failed_) {
+                    // The reaper can no longer be woken; leave it and the
+                    // ring it reads from alone rather than unmap them.
+                    LOG_ERROR("Cannot stop the io_uring reaper");
+                    reaper_.detach();
+                    return;
+                }
+            }
+            reaper_.join();
+        }
+        
+        if (sqes_ != MAP_FAILED) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0) {
+            ::close(ring_fd_);
+        }
+    }
+    
+    // False if the kernel refuses io_uring; the caller falls back.
+    bool init() {
+        io_uring_params params{};
+        ring_fd_ = io_uring_setup(static_cast<unsigned>(slots_.size() + 1), &params);
+        if (ring_fd_ < 0) {
+            return false;
+        }
+        if (!supports_read()) {
+            errno = EOPNOTSUPP;
+            return false;
+        }
+        
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+        
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        cq_ring_ = single_mmap ? sq_ring_
+                               : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                      ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ring_fd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+        
+        char* sq = static_cast<char*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_submitted_ = *sq_tail_;
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        
+        char* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        
+        reaper_ = std::thread(&UringReadEngine::reap, this);
+        return true;
+    }
+    
+    const char* name() const override {
+        return "io_uring";
+    }
+    
+protected:
+    void start(std::unique_ptr<Request> request) override {
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        size_t slot = free_slots_.back();
+        free_slots_.pop_back();
+        slots_[slot] = std::move(request);
+        queue_read(slot);
+    }
+    
+private:
+    static constexpr uint64_t kWakeTag = ~uint64_t(0);
+    static constexpr int kSubmitRetries = 100;
+    
+    int ring_fd_;
+    void* sq_ring_;
+    void* cq_ring_;
+    void* sqes_;
+    size_t sq_ring_size_;
+    size_t cq_ring_size_;
+    size_t sqes_size_;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    
+    std::mutex submit_mutex_;
+    // SQ tail up to which the kernel has taken entries, and entries it
+    // took whose completions have not been reaped. Both need submit_mutex_.
+    unsigned sq_submitted_;
+    size_t kernel_in_flight_;
+    std::vector<std::unique_ptr<Request>> slots_;
+    std::vector<size_t> free_slots_;
+    bool stopping_;
+    bool wake_failed_;
+    std::thread reaper_;
+    
+    // Requires submit_mutex_. Every read holds one of queue_depth slots and
+    // the ring has one entry more for the wake-up, so it never overflows.
+    io_uring_sqe* next_sqe() {
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        return sqe;
+    }
+    
+    // IORING_OP_READ arrived in 5.6, together with the probe; on older
+    // kernels the ring works but every read would fail with EINVAL.
+    bool supports_read() {
+        size_t probe_size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+        std::vector<char> storage(probe_size, 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (io_uring_register(ring_fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+        return IORING_OP_READ <= probe->last_op && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+    }
+    
+    // Requires submit_mutex_. Publishes the entry from next_sqe() and hands
+    // the kernel every entry it has not taken yet.
+    void submit_locked() {
+        std::atomic_ref<unsigned>(*sq_tail_).store(*sq_tail_ + 1, std::memory_order_release);
+        submit_pending();
+    }
+    
+    // Requires submit_mutex_. When the kernel is short of resources (EAGAIN,
+    // or EBUSY while completions are waiting) and reads are in flight, the
+    // rest stays queued and the reaper submits it after the next
+    // completions. With nothing in flight nobody would retry, so this
+    // retries briefly and then fails the entries, as on any other error.
+    void submit_pending() {
+        int retries = 0;
+        while (sq_submitted_ != *sq_tail_) {
+            int taken = io_uring_enter(ring_fd_, *sq_tail_ - sq_submitted_, 0, 0);
+            if (taken > 0) {
+                sq_submitted_ += static_cast<unsigned>(taken);
+                kernel_in_flight_ += static_cast<size_t>(taken);
+                continue;
+            }
+            
+            int error = taken < 0 ? errno : EAGAIN;
+            if (error == EINTR) {
+                continue;
+            }
+            if (error == EAGAIN || error == EBUSY) {
+                if (kernel_in_flight_ > 0) {
+                    return;
+                }
+                if (++retries <= kSubmitRetries) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+            }
+            fail_pending(error);
+            return;
+        }
+    }
+    
+    // Requires submit_mutex_. Takes back the entries the kernel has not
+    // seen and fails their reads.
+    void fail_pending(int error) {
+        LOG_ERROR("io_uring submit failed: {}", std::strerror(error));
+        
+        std::vector<size_t> failed;
+        for (unsigned tail = sq_submitted_; tail != *sq_tail_; ++tail) {
+            uint64_t tag = static_cast<io_uring_sqe*>(sqes_)[tail & sq_mask_].user_data;
+            if (tag == kWakeTag) {
+                wake_failed_ = true;
+            } else {
+                failed.push_back(static_cast<size_t>(tag));
+            }
+        }
+        std::atomic_ref<unsigned>(*sq_tail_).store(sq_submitted_, std::memory_order_release);
+        
+        for (size_t slot : failed) {
+            complete(std::move(slots_[slot]), error);
+            free_slots_.push_back(slot);
+        }
+    }
+    
+    void queue_read(size_t slot) {
+        Request& request = *slots_[slot];
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = request.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(request.data.get() + request.done);
+        sqe->len = static_cast<unsigned>(std::min<size_t>(request.size - request.done, 1u << 30));
+        sqe->off = request.done;
+        sqe->user_data = slot;
+        submit_locked();
+    }
+    
+    void reap() {
+        while (true) {
+            if (io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                LOG_ERROR("io_uring wait failed: {}", std::strerror(errno));
+                return;
+            }
+            
+            unsigned head = *cq_head_;
+            unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+            unsigned reaped = tail - head;
+            bool wake = false;
+            
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                if (cqe.user_data == kWakeTag) {
+                    wake = true;
+                } else {
+                    finish_read(static_cast<size_t>(cqe.user_data), cqe.res);
+                }
+            }
+            std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+            
+            // Completions free kernel resources, so entries a submit had to
+            // leave queued go in now.
+            {
+                std::lock_guard<std::mutex> lock(submit_mutex_);
+                kernel_in_flight_ -= reaped;
+                submit_pending();
+            }
+            
+            if (wake) {
+                return;
+            }
+        }
+    }
+    
+    void finish_read(size_t slot, int res) {
+        std::unique_ptr<Request> done;
+        int error = 0;
+        {
+            std::lock_guard<std::mutex> lock(submit_mutex_);
+            Request& request = *slots_[slot];
+            
+            if (res == -EINTR || res == -EAGAIN) {
+                queue_read(slot);
+                return;
+            }
+            if (res > 0) {
+                request.done += static_cast<size_t>(res);
+                if (request.done < request.size) {
+                    queue_read(slot);
+                    return;
+                }
+            } else if (res < 0) {
+                error = -res;
+            }
+            
+            done = std::move(slots_[slot]);
+            free_slots_.push_back(slot);
+        }
+        complete(std::move(done), error);
+    }
+};
+
+}
+
+std::unique_ptr<ReadEngine> ReadEngine::create(size_t queue_depth, size_t max_buffered_bytes, bool allow_uring) {
+    if (allow_uring) {
+        auto engine = std::make_unique<UringReadEngine>(queue_depth, max_buffered_bytes);
+        if (engine->init()) {
+            return engine;
+        }
+        LOG_WARNING("io_uring unavailable ({}), using threaded reads", std::strerror(errno));
+    }
+    return std::make_unique<ThreadReadEngine>(queue_depth, max_buffered_bytes);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../../include/common.h"
+
+class ReadEngine;
+
+// Whole contents of a file read by a ReadEngine. The engine counts the
+// bytes as buffered until this is destroyed, which is what bounds how
+// far reads may run ahead of analysis.
+class ReadBuffer {
+public:
+    ReadBuffer() = default;
+    ReadBuffer(std::unique_ptr<char[]> data, size_t size, int error, ReadEngine* owner, size_t accounted);
+    ~ReadBuffer();
+    
+    ReadBuffer(ReadBuffer&& other) noexcept;
+    ReadBuffer& operator=(ReadBuffer&& other) noexcept;
+    ReadBuffer(const ReadBuffer&) = delete;
+    ReadBuffer& operator=(const ReadBuffer&) = delete;
+    
+    // 0 on success, otherwise an errno value.
+    int error() const { return error_; }
+    std::string_view view() const { return std::string_view(data_.get(), size_); }
+    
+private:
+    std::unique_ptr<char[]> data_;
+    size_t size_ = 0;
+    int error_ = 0;
+    ReadEngine* owner_ = nullptr;
+    size_t accounted_ = 0;
+    
+    void release();
+};
+
+// Reads whole files ahead of the workers that analyze them, keeping up to
+// queue_depth reads in flight across files. The io_uring engine submits
+// them all to the kernel from one thread; where io_uring is unavailable
+// (old kernel, seccomp, io_uring_disabled) a small pool of threads issues
+// blocking reads instead.
+class ReadEngine {
+public:
+    // Prefers io_uring unless allow_uring is false.
+    static std::unique_ptr<ReadEngine> create(size_t queue_depth, size_t max_buffered_bytes,
+                                              bool allow_uring = true);
+    
+    virtual ~ReadEngine() = default;
+    
+    // Opens path and starts reading it; blocks while queue_depth reads are
+    // already in flight. Open and stat errors come back as a ready future.
+    std::future<ReadBuffer> read(const std::string& path);
+    
+    // Blocks until bytes more can be buffered without exceeding the
+    // budget, or nothing is buffered (so an oversized file still runs).
+    // Call before issuing the reads for a unit of work, never between
+    // them: only buffers already handed to consumers are waited on.
+    void wait_for_buffer_space(size_t bytes);
+    
+    size_t buffered_bytes() const;
+    virtual const char* name() const = 0;
+    
+protected:
+    struct Request {
+        int fd = -1;
+        // Left uninitialised; the read overwrites it.
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+        size_t done = 0;
+        size_t accounted = 0;
+        std::promise<ReadBuffer> promise;
+    };
+    
+    ReadEngine(size_t queue_depth, size_t max_buffered_bytes);
+    
+    // Starts (or, after a short read, continues) reading into
+    // request->data from offset request->done.
+    virtual void start(std::unique_ptr<Request> request) = 0;
+    
+    // Closes the file and fulfils the promise; error is an errno value.
+    void complete(std::unique_ptr<Request> request, int error);
+    
+    // Blocks until no read is in flight.
+    void drain();
+    
+private:
+    friend class ReadBuffer;
+    
+    size_t queue_depth_;
+    size_t max_buffered_bytes_;
+    size_t in_flight_;
+    size_t buffered_bytes_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    
+    void release_buffer(size_t bytes);
+};
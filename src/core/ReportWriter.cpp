@@ -0,0 +1,252 @@
+#include "ReportWriter.h"
+#include "../utils/Logger.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+}
+
+ReportWriter::ReportWriter(size_t queue_capacity)
+    : queue_(queue_capacity), format_(ReportFormat::FILES), stream_fd_(-1), reports_written_(0),
+      write_errors_(0) {
+    writer_ = std::thread(&ReportWriter::writer_loop, this);
+}
+
+ReportWriter::~ReportWriter() {
+    Request stop;
+    stop.kind = Kind::STOP;
+    queue_.push(std::move(stop));
+    writer_.join();
+    
+    if (stream_fd_ >= 0) {
+        ::close(stream_fd_);
+    }
+}
+
+bool ReportWriter::open_stream(const std::string& path, bool keep_previous) {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    
+    // A ".prev" still present means the run that set it aside stopped early
+    // and left a partial stream; the set-aside one is the complete one.
+    previous_path_ = path + ".prev";
+    if (keep_previous) {
+        if (!fs::exists(previous_path_, ec)) {
+            fs::rename(path, previous_path_, ec);
+        }
+        std::ifstream previous(previous_path_, std::ios::binary);
+        previous_.assign(std::istreambuf_iterator<char>(previous), std::istreambuf_iterator<char>());
+        index_previous();
+    } else {
+        fs::remove(previous_path_, ec);
+    }
+    
+    stream_fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (stream_fd_ < 0) {
+        LOG_ERROR("Cannot open report stream {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    
+    stream_path_ = path;
+    stream_buffer_.reserve(kBufferBytes);
+    format_ = ReportFormat::NDJSON;
+    return true;
+}
+
+// Records start with {"file":"..."}, written by append_json_string, so an
+// unescaped quote ends the key.
+void ReportWriter::index_previous() {
+    static constexpr std::string_view kPrefix = "{\"file\":\"";
+    std::string_view rest = previous_;
+    while (!rest.empty()) {
+        size_t line_end = rest.find('\n');
+        std::string_view line = rest.substr(0, line_end == std::string_view::npos ? rest.size() : line_end + 1);
+        rest.remove_prefix(line.size());
+        if (line.back() != '\n' || line.substr(0, kPrefix.size()) != kPrefix) {
+            continue;
+        }
+        
+        size_t quote = kPrefix.size();
+        while (quote < line.size() && line[quote] != '"') {
+            quote += line[quote] == '\\' ? 2 : 1;
+        }
+        if (quote < line.size()) {
+            std::string_view key = line.substr(kPrefix.size() - 1, quote - kPrefix.size() + 2);
+            previous_records_[key] = line;
+        }
+    }
+}
+
+bool ReportWriter::carry_over(const std::string& file) {
+    if (previous_records_.empty()) {
+        return false;
+    }
+    
+    std::string key;
+    append_json_string(key, file);
+    auto record = previous_records_.find(key);
+    if (record == previous_records_.end()) {
+        return false;
+    }
+    append(std::string(record->second));
+    previous_records_.erase(record);
+    return true;
+}
+
+void ReportWriter::drop_previous() {
+    previous_records_.clear();
+    std::string().swap(previous_);
+    if (!previous_path_.empty()) {
+        std::error_code ec;
+        fs::remove(previous_path_, ec);
+    }
+}
+
+ReportFormat ReportWriter::format() const {
+    return format_;
+}
+
+const std::string& ReportWriter::stream_path() const {
+    return stream_path_;
+}
+
+void ReportWriter::write(std::string path, std::string contents) {
+    Request request;
+    request.kind = Kind::WRITE;
+    request.path = std::move(path);
+    request.data = std::move(contents);
+    queue_.push(std::move(request));
+}
+
+void ReportWriter::copy(std::string from, std::string to) {
+    Request request;
+    request.kind = Kind::COPY;
+    request.path = std::move(to);
+    request.data = std::move(from);
+    queue_.push(std::move(request));
+}
+
+void ReportWriter::append(std::string record) {
+    Request request;
+    request.kind = Kind::APPEND;
+    request.data = std::move(record);
+    queue_.push(std::move(request));
+}
+
+void ReportWriter::flush() {
+    std::promise<void> flushed;
+    std::future<void> done = flushed.get_future();
+    Request request;
+    request.kind = Kind::FLUSH;
+    request.flushed = &flushed;
+    queue_.push(std::move(request));
+    done.wait();
+}
+
+size_t ReportWriter::reports_written() const {
+    return reports_written_.load();
+}
+
+size_t ReportWriter::write_errors() const {
+    return write_errors_.load();
+}
+
+bool ReportWriter::write_file(const std::string& path, std::string_view contents) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == ENOENT) {
+        std::error_code ec;
+        fs::create_directories(fs::path(path).parent_path(), ec);
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        return false;
+    }
+    
+    bool ok = write_all(fd, contents);
+    return ::close(fd) == 0 && ok;
+}
+
+void ReportWriter::writer_loop() {
+    while (true) {
+        Request request;
+        queue_.wait_and_pop(request);
+        
+        bool stop = false;
+        
+        // Take everything already queued, so stream records that arrive
+        // together leave in one write.
+        do {
+            switch (request.kind) {
+                case Kind::WRITE:
+                    if (write_file(request.path, request.data)) {
+                        ++reports_written_;
+                    } else {
+                        ++write_errors_;
+                        LOG_ERROR("Cannot write analysis report {}: {}", request.path, std::strerror(errno));
+                    }
+                    break;
+                case Kind::COPY: {
+                    std::error_code ec;
+                    fs::copy_file(request.data, request.path, fs::copy_options::overwrite_existing, ec);
+                    if (ec) {
+                        ++write_errors_;
+                        LOG_ERROR("Cannot copy analysis report to {}: {}", request.path, ec.message());
+                    } else {
+                        ++reports_written_;
+                    }
+                    break;
+                }
+                case Kind::APPEND:
+                    if (stream_buffer_.size() + request.data.size() > kBufferBytes) {
+                        write_stream_buffer();
+                    }
+                    stream_buffer_ += request.data;
+                    ++reports_written_;
+                    break;
+                case Kind::FLUSH:
+                    write_stream_buffer();
+                    request.flushed->set_value();
+                    break;
+                case Kind::STOP:
+                    stop = true;
+                    break;
+            }
+        } while (queue_.try_pop(request));
+        
+        write_stream_buffer();
+        
+        if (stop) {
+            return;
+        }
+    }
+}
+
+void ReportWriter::write_stream_buffer() {
+    if (stream_buffer_.empty()) {
+        return;
+    }
+    
+    if (!write_all(stream_fd_, stream_buffer_)) {
+        ++write_errors_;
+        LOG_ERROR("Cannot write report stream {}: {}", stream_path_, std::strerror(errno));
+    }
+    stream_buffer_.clear();
+}
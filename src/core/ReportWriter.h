@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../../include/common.h"
+#include <charconv>
+
+// Writes analysis reports from a dedicated thread, so workers only format
+// them. The writer takes whatever is queued in one go: in FILES mode each
+// report becomes its own file through a single write(), and in NDJSON
+// mode records are appended to one stream in buffers of up to
+// kBufferBytes, one write() per buffer. Requests are carried out in the
+// order they were queued, so a copy queued after the report it copies
+// finds that report on disk.
+//
+// A report that cannot be written is logged and counted; the result of
+// the file it belongs to is not changed.
+class ReportWriter {
+public:
+    static constexpr size_t kBufferBytes = 1 << 20;
+    
+    explicit ReportWriter(size_t queue_capacity = 4096);
+    
+    // Writes everything still queued.
+    ~ReportWriter();
+    
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+    
+    // Sends every report to one NDJSON stream at path instead of a file of
+    // its own. The stream is rewritten; with keep_previous its current
+    // records are set aside in path + ".prev" so carry_over() can copy
+    // those of files that are not analyzed again. Call before queueing
+    // anything.
+    bool open_stream(const std::string& path, bool keep_previous);
+    
+    // Queues the previous stream's record of file, if it has one. Each
+    // record is carried over at most once. Only the thread that opened the
+    // stream may call this.
+    bool carry_over(const std::string& file);
+    
+    // Forgets the previous stream and deletes its file, once the new stream
+    // holds every record worth keeping.
+    void drop_previous();
+    
+    ReportFormat format() const;
+    const std::string& stream_path() const;
+    
+    // Queues a whole report file (FILES mode).
+    void write(std::string path, std::string contents);
+    
+    // Queues a copy of a report queued earlier (FILES mode).
+    void copy(std::string from, std::string to);
+    
+    // Queues one newline-terminated record for the stream (NDJSON mode).
+    void append(std::string record);
+    
+    // Blocks until everything queued before the call is written.
+    void flush();
+    
+    size_t reports_written() const;
+    size_t write_errors() const;
+    
+    // Replaces path with contents in one write(), creating the directory
+    // if it is missing.
+    static bool write_file(const std::string& path, std::string_view contents);
+    
+private:
+    enum class Kind : uint8_t {
+        WRITE,
+        COPY,
+        APPEND,
+        FLUSH,
+        STOP
+    };
+    
+    struct Request {
+        Kind kind = Kind::FLUSH;
+        std::string path;
+        std::string data;
+        std::promise<void>* flushed = nullptr;
+    };
+    
+    LockFreeQueue<Request> queue_;
+    ReportFormat format_;
+    std::string stream_path_;
+    int stream_fd_;
+    std::string stream_buffer_;
+    std::string previous_path_;
+    std::string previous_;
+    // Record lines of previous_, keyed by their quoted "file" value.
+    std::unordered_map<std::string_view, std::string_view> previous_records_;
+    std::atomic<size_t> reports_written_;
+    std::atomic<size_t> write_errors_;
+    std::thread writer_;
+    
+    void writer_loop();
+    void write_stream_buffer();
+    void index_previous();
+};
+
+inline void append_decimal(std::string& out, uint64_t value) {
+    char digits[20];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+}
+
+// Appends value as a quoted JSON string.
+inline void append_json_string(std::string& out, std::string_view value) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : value) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (byte < 0x20) {
+            out += "\\u00";
+            out += kHex[byte >> 4];
+            out += kHex[byte & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
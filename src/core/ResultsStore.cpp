@@ -0,0 +1,365 @@
+#include "ResultsStore.h"
+#include "ReportWriter.h"
+#include "../utils/Logger.h"
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+static_assert(std::endian::native == std::endian::little, "results files are written in host byte order");
+
+namespace {
+
+struct ColumnSpec {
+    ResultsColumn id;
+    uint32_t element_size;
+};
+
+constexpr ColumnSpec kColumns[] = {
+    {ResultsColumn::FILE_PATH_OFFSET, 8},
+    {ResultsColumn::FILE_PATH_LENGTH, 4},
+    {ResultsColumn::LINES, 8},
+    {ResultsColumn::WORDS, 8},
+    {ResultsColumn::CHARACTERS, 8},
+    {ResultsColumn::PARAGRAPHS, 8},
+    {ResultsColumn::BYTES, 8},
+    {ResultsColumn::PROCESSING_MS, 8},
+    {ResultsColumn::FILE_WORDS_BEGIN, 8},
+    {ResultsColumn::WORD_TEXT_OFFSET, 8},
+    {ResultsColumn::WORD_TEXT_LENGTH, 4},
+    {ResultsColumn::WORD_COUNT, 8},
+    {ResultsColumn::STRINGS, 1},
+};
+
+constexpr size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+
+size_t align8(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+uint64_t metadata_number(const ProcessResult& result, const char* key) {
+    auto it = result.metadata.find(key);
+    uint64_t value = 0;
+    if (it != result.metadata.end()) {
+        std::from_chars(it->second.data(), it->second.data() + it->second.size(), value);
+    }
+    return value;
+}
+
+// Rows of one column, appended to the file image in column order.
+template<typename T>
+void append_column(std::string& image, const std::vector<T>& values) {
+    image.resize(align8(image.size()));
+    image.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+}
+
+ResultsStore::ResultsStore(std::string path) : path_(std::move(path)) {}
+
+void ResultsStore::add(const ProcessResult& result) {
+    if (!result.success) {
+        return;
+    }
+    
+    auto [it, inserted] = row_index_.try_emplace(result.input_path, rows_.size());
+    if (inserted) {
+        rows_.emplace_back();
+    }
+    
+    Row& row = rows_[it->second];
+    row.path = result.input_path;
+    row.lines = metadata_number(result, "lines");
+    row.words = metadata_number(result, "words");
+    row.characters = metadata_number(result, "characters");
+    row.paragraphs = metadata_number(result, "paragraphs");
+    row.bytes = result.bytes_processed;
+    row.processing_ms = static_cast<uint64_t>(result.processing_time.count());
+    row.top_words.clear();
+    
+    // "word count word count ..." as written by the processors.
+    auto top = result.metadata.find("top_words");
+    if (top != result.metadata.end()) {
+        std::string_view list = top->second;
+        while (!list.empty()) {
+            size_t word_end = list.find(' ');
+            if (word_end == std::string_view::npos) {
+                break;
+            }
+            size_t count_end = std::min(list.find(' ', word_end + 1), list.size());
+            uint64_t count = 0;
+            std::from_chars(list.data() + word_end + 1, list.data() + count_end, count);
+            row.top_words.emplace_back(std::string(list.substr(0, word_end)), count);
+            list.remove_prefix(std::min(count_end + 1, list.size()));
+        }
+    }
+}
+
+bool ResultsStore::save() const {
+    size_t file_count = rows_.size();
+    std::vector<uint64_t> path_offsets, lines, words, characters, paragraphs, bytes, processing_ms;
+    std::vector<uint32_t> path_lengths;
+    std::vector<uint64_t> words_begin = {0};
+    std::vector<uint64_t> word_offsets, word_counts;
+    std::vector<uint32_t> word_lengths;
+    std::vector<char> strings;
+    
+    for (const Row& row : rows_) {
+        path_offsets.push_back(strings.size());
+        path_lengths.push_back(static_cast<uint32_t>(row.path.size()));
+        strings.insert(strings.end(), row.path.begin(), row.path.end());
+        lines.push_back(row.lines);
+        words.push_back(row.words);
+        characters.push_back(row.characters);
+        paragraphs.push_back(row.paragraphs);
+        bytes.push_back(row.bytes);
+        processing_ms.push_back(row.processing_ms);
+        
+        for (const auto& [word, count] : row.top_words) {
+            word_offsets.push_back(strings.size());
+            word_lengths.push_back(static_cast<uint32_t>(word.size()));
+            word_counts.push_back(count);
+            strings.insert(strings.end(), word.begin(), word.end());
+        }
+        words_begin.push_back(word_counts.size());
+    }
+    
+    ResultsHeader header{};
+    std::memcpy(header.magic, kResultsMagic, sizeof(header.magic));
+    header.version = kResultsVersion;
+    header.column_count = kColumnCount;
+    header.file_count = file_count;
+    header.word_count = word_counts.size();
+    header.columns_offset = sizeof(ResultsHeader);
+    
+    std::string image(sizeof(ResultsHeader) + kColumnCount * sizeof(ResultsColumnEntry), '\0');
+    ResultsColumnEntry entries[kColumnCount];
+    auto place = [&](size_t index, const auto& values) {
+        using Value = typename std::decay_t<decltype(values)>::value_type;
+        append_column(image, values);
+        entries[index] = ResultsColumnEntry{static_cast<uint32_t>(kColumns[index].id), sizeof(Value),
+                                            image.size() - values.size() * sizeof(Value), values.size()};
+    };
+    place(0, path_offsets);
+    place(1, path_lengths);
+    place(2, lines);
+    place(3, words);
+    place(4, characters);
+    place(5, paragraphs);
+    place(6, bytes);
+    place(7, processing_ms);
+    place(8, words_begin);
+    place(9, word_offsets);
+    place(10, word_lengths);
+    place(11, word_counts);
+    place(12, strings);
+    image.resize(align8(image.size()));
+    
+    header.total_size = image.size();
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + header.columns_offset, entries, sizeof(entries));
+    
+    std::string temporary = path_ + ".tmp";
+    if (!ReportWriter::write_file(temporary, image)) {
+        LOG_ERROR("Cannot write results file: {}", temporary);
+        return false;
+    }
+    std::error_code ec;
+    fs::rename(temporary, path_, ec);
+    if (ec) {
+        LOG_ERROR("Cannot replace results file {}: {}", path_, ec.message());
+        return false;
+    }
+    return true;
+}
+
+const std::string& ResultsStore::path() const {
+    return path_;
+}
+
+size_t ResultsStore::size() const {
+    return rows_.size();
+}
+
+bool ResultsReader::open(const std::string& path) {
+    error_.clear();
+    base_ = nullptr;
+    file_count_ = 0;
+    word_count_ = 0;
+    std::fill(std::begin(columns_), std::end(columns_), nullptr);
+    
+    if (!input_.open(path, InputMode::MMAP) || !input_.is_mapped()) {
+        return fail("cannot map " + path + (input_.error().empty() ? "" : ": " + input_.error()));
+    }
+    base_ = input_.view().data();
+    mapped_bytes_ = input_.size();
+    
+    if (mapped_bytes_ < sizeof(ResultsHeader)) {
+        return fail("file too short for a header");
+    }
+    ResultsHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    if (std::memcmp(header.magic, kResultsMagic, sizeof(header.magic)) != 0) {
+        return fail("not a results file");
+    }
+    if (header.version != kResultsVersion) {
+        return fail("unsupported version " + std::to_string(header.version));
+    }
+    if (header.total_size != mapped_bytes_) {
+        return fail("size mismatch: header says " + std::to_string(header.total_size) + " bytes, file has " +
+                    std::to_string(mapped_bytes_));
+    }
+    
+    version_ = header.version;
+    file_count_ = header.file_count;
+    word_count_ = header.word_count;
+    return validate_columns(header);
+}
+
+bool ResultsReader::validate_columns(const ResultsHeader& header) {
+    if (header.columns_offset % 8 != 0 || header.columns_offset > mapped_bytes_ ||
+        header.column_count > (mapped_bytes_ - header.columns_offset) / sizeof(ResultsColumnEntry)) {
+        return fail("column directory out of bounds");
+    }
+    
+    uint64_t string_bytes = 0;
+    for (uint32_t i = 0; i < header.column_count; ++i) {
+        ResultsColumnEntry entry;
+        std::memcpy(&entry, base_ + header.columns_offset + i * sizeof(entry), sizeof(entry));
+        
+        const ColumnSpec* spec = nullptr;
+        for (const ColumnSpec& known : kColumns) {
+            if (static_cast<uint32_t>(known.id) == entry.id) {
+                spec = &known;
+            }
+        }
+        if (!spec) {
+            continue;
+        }
+        
+        uint64_t expected = file_count_;
+        if (spec->id == ResultsColumn::FILE_WORDS_BEGIN) {
+            expected = file_count_ + 1;
+        } else if (spec->id == ResultsColumn::WORD_TEXT_OFFSET || spec->id == ResultsColumn::WORD_TEXT_LENGTH ||
+                   spec->id == ResultsColumn::WORD_COUNT) {
+            expected = word_count_;
+        } else if (spec->id == ResultsColumn::STRINGS) {
+            expected = entry.count;
+            string_bytes = entry.count;
+        }
+        
+        if (entry.element_size != spec->element_size || entry.count != expected || entry.offset % 8 != 0 ||
+            entry.offset > mapped_bytes_ || entry.count > (mapped_bytes_ - entry.offset) / entry.element_size) {
+            return fail("column " + std::to_string(entry.id) + " is malformed");
+        }
+        columns_[entry.id] = base_ + entry.offset;
+    }
+    
+    for (const ColumnSpec& known : kColumns) {
+        if (!columns_[static_cast<uint32_t>(known.id)]) {
+            return fail("column " + std::to_string(static_cast<uint32_t>(known.id)) + " is missing");
+        }
+    }
+    
+    // Checked once here so the accessors need no bounds checks.
+    const uint64_t* begin = data<uint64_t>(ResultsColumn::FILE_WORDS_BEGIN);
+    const uint64_t* path_offsets = data<uint64_t>(ResultsColumn::FILE_PATH_OFFSET);
+    const uint32_t* path_lengths = data<uint32_t>(ResultsColumn::FILE_PATH_LENGTH);
+    if (begin[0] != 0 || begin[file_count_] != word_count_) {
+        return fail("word table index is inconsistent");
+    }
+    for (uint64_t i = 0; i < file_count_; ++i) {
+        if (begin[i] > begin[i + 1] || path_offsets[i] > string_bytes ||
+            path_lengths[i] > string_bytes - path_offsets[i]) {
+            return fail("file " + std::to_string(i) + " is malformed");
+        }
+    }
+    const uint64_t* word_offsets = data<uint64_t>(ResultsColumn::WORD_TEXT_OFFSET);
+    const uint32_t* word_lengths = data<uint32_t>(ResultsColumn::WORD_TEXT_LENGTH);
+    for (uint64_t i = 0; i < word_count_; ++i) {
+        if (word_offsets[i] > string_bytes || word_lengths[i] > string_bytes - word_offsets[i]) {
+            return fail("word " + std::to_string(i) + " is malformed");
+        }
+    }
+    
+    return true;
+}
+
+const std::string& ResultsReader::error() const {
+    return error_;
+}
+
+uint32_t ResultsReader::version() const {
+    return version_;
+}
+
+size_t ResultsReader::size() const {
+    return file_count_;
+}
+
+std::string_view ResultsReader::path(size_t file) const {
+    return string_at(data<uint64_t>(ResultsColumn::FILE_PATH_OFFSET)[file],
+                     data<uint32_t>(ResultsColumn::FILE_PATH_LENGTH)[file]);
+}
+
+uint64_t ResultsReader::lines(size_t file) const {
+    return data<uint64_t>(ResultsColumn::LINES)[file];
+}
+
+uint64_t ResultsReader::words(size_t file) const {
+    return data<uint64_t>(ResultsColumn::WORDS)[file];
+}
+
+uint64_t ResultsReader::characters(size_t file) const {
+    return data<uint64_t>(ResultsColumn::CHARACTERS)[file];
+}
+
+uint64_t ResultsReader::paragraphs(size_t file) const {
+    return data<uint64_t>(ResultsColumn::PARAGRAPHS)[file];
+}
+
+uint64_t ResultsReader::bytes(size_t file) const {
+    return data<uint64_t>(ResultsColumn::BYTES)[file];
+}
+
+uint64_t ResultsReader::processing_ms(size_t file) const {
+    return data<uint64_t>(ResultsColumn::PROCESSING_MS)[file];
+}
+
+size_t ResultsReader::top_word_count(size_t file) const {
+    const uint64_t* begin = data<uint64_t>(ResultsColumn::FILE_WORDS_BEGIN);
+    return static_cast<size_t>(begin[file + 1] - begin[file]);
+}
+
+ResultsReader::WordCount ResultsReader::top_word(size_t file, size_t rank) const {
+    size_t row = static_cast<size_t>(data<uint64_t>(ResultsColumn::FILE_WORDS_BEGIN)[file]) + rank;
+    return WordCount{string_at(data<uint64_t>(ResultsColumn::WORD_TEXT_OFFSET)[row],
+                               data<uint32_t>(ResultsColumn::WORD_TEXT_LENGTH)[row]),
+                     data<uint64_t>(ResultsColumn::WORD_COUNT)[row]};
+}
+
+std::span<const uint64_t> ResultsReader::column(ResultsColumn column) const {
+    switch (column) {
+        case ResultsColumn::LINES:
+        case ResultsColumn::WORDS:
+        case ResultsColumn::CHARACTERS:
+        case ResultsColumn::PARAGRAPHS:
+        case ResultsColumn::BYTES:
+        case ResultsColumn::PROCESSING_MS:
+            return std::span<const uint64_t>(data<uint64_t>(column), file_count_);
+        default:
+            return {};
+    }
+}
+
+std::string_view ResultsReader::string_at(uint64_t offset, uint32_t length) const {
+    return std::string_view(columns_[static_cast<uint32_t>(ResultsColumn::STRINGS)] + offset, length);
+}
+
+bool ResultsReader::fail(std::string message) {
+    error_ = std::move(message);
+    base_ = nullptr;
+    file_count_ = 0;
+    word_count_ = 0;
+    input_.close();
+    return false;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "../../include/common.h"
+#include "InputFile.h"
+#include <span>
+
+// Binary, column-oriented results file: every per-file metric is stored
+// as one contiguous array, so a reader can map the file and scan a
+// metric for the whole corpus without parsing anything.
+//
+// Layout, little-endian, every section 8-byte aligned:
+//   ResultsHeader                         at offset 0
+//   ResultsColumnEntry[column_count]      at columns_offset
+//   column data                           where each entry points
+//
+// Per-file columns hold file_count values; FILE_WORDS_BEGIN holds
+// file_count + 1, so file i's top words are the word-table rows
+// [begin[i], begin[i + 1]). Word-table columns hold word_count values.
+// Paths and words are (offset, length) references into the STRINGS
+// column. Readers ignore columns they do not know; a new version number
+// is only needed for changes old readers would misread.
+enum class ResultsColumn : uint32_t {
+    FILE_PATH_OFFSET = 1,   // uint64
+    FILE_PATH_LENGTH = 2,   // uint32
+    LINES = 3,              // uint64
+    WORDS = 4,              // uint64
+    CHARACTERS = 5,         // uint64
+    PARAGRAPHS = 6,         // uint64
+    BYTES = 7,              // uint64
+    PROCESSING_MS = 8,      // uint64
+    FILE_WORDS_BEGIN = 9,   // uint64
+    WORD_TEXT_OFFSET = 10,  // uint64
+    WORD_TEXT_LENGTH = 11,  // uint32
+    WORD_COUNT = 12,        // uint64
+    STRINGS = 13            // bytes
+};
+
+struct ResultsHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t file_count;
+    uint64_t word_count;
+    uint64_t columns_offset;
+    uint64_t total_size;
+    uint64_t reserved[2];
+};
+
+struct ResultsColumnEntry {
+    uint32_t id;
+    uint32_t element_size;
+    uint64_t offset;
+    uint64_t count;
+};
+
+static_assert(sizeof(ResultsHeader) == 64 && sizeof(ResultsColumnEntry) == 24);
+
+inline constexpr char kResultsMagic[8] = {'F', 'P', 'R', 'E', 'S', 'U', 'L', 'T'};
+inline constexpr uint32_t kResultsVersion = 1;
+
+// Collects the results of a run and writes them as a results file. A path
+// added again (watch mode) replaces its earlier row.
+//
+// Not thread-safe: the thread that collects results owns it.
+class ResultsStore {
+public:
+    explicit ResultsStore(std::string path);
+    
+    // Takes the metrics from a successful result's metadata; failed
+    // results are ignored.
+    void add(const ProcessResult& result);
+    
+    // Writes every row, replacing the file atomically.
+    bool save() const;
+    
+    const std::string& path() const;
+    size_t size() const;
+    
+private:
+    struct Row {
+        std::string path;
+        uint64_t lines = 0;
+        uint64_t words = 0;
+        uint64_t characters = 0;
+        uint64_t paragraphs = 0;
+        uint64_t bytes = 0;
+        uint64_t processing_ms = 0;
+        std::vector<std::pair<std::string, uint64_t>> top_words;
+    };
+    
+    std::string path_;
+    std::vector<Row> rows_;
+    std::unordered_map<std::string, size_t> row_index_;
+};
+
+// Read-only view of a results file. Everything is validated once in
+// open(); the accessors then index the mapping directly.
+class ResultsReader {
+public:
+    struct WordCount {
+        std::string_view word;
+        uint64_t count;
+    };
+    
+    // Returns false and sets error() if the file is missing, truncated,
+    // of another version or inconsistent.
+    bool open(const std::string& path);
+    const std::string& error() const;
+    
+    uint32_t version() const;
+    size_t size() const;
+    
+    std::string_view path(size_t file) const;
+    uint64_t lines(size_t file) const;
+    uint64_t words(size_t file) const;
+    uint64_t characters(size_t file) const;
+    uint64_t paragraphs(size_t file) const;
+    uint64_t bytes(size_t file) const;
+    uint64_t processing_ms(size_t file) const;
+    
+    // Top words of a file, most frequent first.
+    size_t top_word_count(size_t file) const;
+    WordCount top_word(size_t file, size_t rank) const;
+    
+    // A whole per-file uint64 metric column (LINES through PROCESSING_MS),
+    // straight from the mapping.
+    std::span<const uint64_t> column(ResultsColumn column) const;
+    
+private:
+    InputFile input_;
+    std::string error_;
+    const char* base_ = nullptr;
+    size_t mapped_bytes_ = 0;
+    uint64_t file_count_ = 0;
+    uint64_t word_count_ = 0;
+    uint32_t version_ = 0;
+    // Start of each known column, indexed by ResultsColumn.
+    const char* columns_[16] = {};
+    
+    template<typename T>
+    const T* data(ResultsColumn column) const {
+        return reinterpret_cast<const T*>(columns_[static_cast<uint32_t>(column)]);
+    }
+    
+    std::string_view string_at(uint64_t offset, uint32_t length) const;
+    bool validate_columns(const ResultsHeader& header);
+    bool fail(std::string message);
+};
@@ -1,11 +1,24 @@
 #include "ThreadPool.h"
 #include "../utils/Logger.h"
+#include "../utils/Timer.h"
+
+thread_local ThreadPool* ThreadPool::current_pool_ = nullptr;
+thread_local size_t ThreadPool::current_index_ = 0;
+thread_local std::chrono::microseconds ThreadPool::nested_cpu_time_{0};
+
+ThreadPool::ThreadPool(size_t num_threads, size_t max_pending, QueueFullPolicy policy)
+    : stop_(false), active_tasks_(0), pending_tasks_(0), idle_workers_(0),
+      searching_workers_(0), next_queue_(0), max_pending_(max_pending),
+      full_policy_(policy), blocked_producers_(0) {
+    num_threads = std::max<size_t>(num_threads, 1);
+    LOG_INFO("Creating ThreadPool with {} threads", num_threads);
+
+    for (size_t i = 0; i < num_threads; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
 
-ThreadPool::ThreadPool(size_t num_threads) : stop_(false), active_tasks_(0) {
-    Logger::getInstance().info("Creating ThreadPool with " + std::to_string(num_threads) + " threads");
-    
     for (size_t i = 0; i < num_threads; ++i) {
-        workers_.emplace_back(&ThreadPool::worker_thread, this);
+        workers_.emplace_back(&ThreadPool::worker_thread, this, i);
     }
 }
 
@@ -13,45 +26,234 @@ ThreadPool::~ThreadPool() {
     shutdown();
 }
 
-void ThreadPool::worker_thread() {
-    while (!stop_) {
+bool ThreadPool::acquire_slot() {
+    // The slot is counted before the push so a waking worker never sees the
+    // task without the counter; a momentary miss just costs one more scan.
+    if (max_pending_ == 0 || current_pool_ == this) {
+        pending_tasks_.fetch_add(1);
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(space_mutex_);
+    if (full_policy_ == QueueFullPolicy::FAIL) {
+        if (pending_tasks_.load() >= max_pending_) {
+            return false;
+        }
+    } else {
+        ++blocked_producers_;
+        space_.wait(lock, [this] {
+            return stop_.load() || pending_tasks_.load() < max_pending_;
+        });
+        --blocked_producers_;
+
+        if (stop_) {
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+    }
+
+    pending_tasks_.fetch_add(1);
+    return true;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (current_pool_ == this) {
+        WorkQueue& queue = *queues_[current_index_];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_front(std::move(task));
+        queue.size.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        WorkQueue& queue = *queues_[next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queue.size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // A worker that is already searching will find this task; waking more
+    // only adds context switches. Searchers hand the wakeup on when they
+    // succeed, so parked workers are brought in one at a time.
+    if (searching_workers_.load() == 0 && idle_workers_.load() > 0) {
+        wake_one();
+    }
+}
+
+void ThreadPool::task_taken() {
+    ++active_tasks_;
+    size_t pending = --pending_tasks_;
+
+    if (pending < max_pending_ && blocked_producers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(space_mutex_);
+        space_.notify_one();
+    }
+}
+
+void ThreadPool::wake_one() {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop_local(size_t index, std::function<void()>& task) {
+    WorkQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    queue.size.fetch_sub(1, std::memory_order_relaxed);
+    task_taken();
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, std::minstd_rand& rng, std::function<void()>& task) {
+    size_t count = queues_.size();
+    size_t start = rng() % count;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (victim == thief) {
+            continue;
+        }
+
+        WorkQueue& queue = *queues_[victim];
+        if (queue.size.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+
+        // The owner works from the front, where its own subtasks go; a
+        // thief takes the back so the two only meet on the last task.
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queue.size.fetch_sub(1, std::memory_order_relaxed);
+            task_taken();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run_task(std::function<void()>& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Task execution failed: {}", e.what());
+    } catch (...) {
+        LOG_ERROR("Task execution failed with unknown exception");
+    }
+
+    if (--active_tasks_ == 0 && pending_tasks_.load() == 0) {
+        std::lock_guard<std::mutex> lock(finished_mutex_);
+        finished_.notify_all();
+    }
+}
+
+void ThreadPool::worker_thread(size_t index) {
+    current_pool_ = this;
+    current_index_ = index;
+    std::minstd_rand rng(static_cast<unsigned>(index + 1));
+    size_t failed_rounds = 0;
+
+    while (true) {
         std::function<void()> task;
-        
-        if (tasks_.try_pop(task)) {
-            try {
-                task();
-            } catch (const std::exception& e) {
-                Logger::getInstance().error("Task execution failed: " + std::string(e.what()));
-            } catch (...) {
-                Logger::getInstance().error("Task execution failed with unknown exception");
-            }
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        if (pop_local(index, task)) {
+            failed_rounds = 0;
+            run_task(task);
+            continue;
+        }
+
+        ++searching_workers_;
+        bool found = steal(index, rng, task);
+        if (--searching_workers_ == 0 && found && pending_tasks_.load() > 0 && idle_workers_.load() > 0) {
+            wake_one();
+        }
+
+        if (found) {
+            failed_rounds = 0;
+            run_task(task);
+            continue;
+        }
+
+        // Yield for a few rounds before parking: a producer that is still
+        // submitting usually refills the queues within a time slice, and
+        // a park/wake cycle costs far more than a yield.
+        if (failed_rounds++ < kSpinRounds) {
+            std::this_thread::yield();
+            continue;
+        }
+        failed_rounds = 0;
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        ++idle_workers_;
+        wake_.wait(lock, [this] {
+            return stop_.load() || pending_tasks_.load() > 0;
+        });
+        --idle_workers_;
+
+        if (stop_ && pending_tasks_.load() == 0) {
+            break;
         }
     }
+
+    current_pool_ = nullptr;
+}
+
+bool ThreadPool::run_pending_task() {
+    std::function<void()> task;
+    bool found = false;
+
+    if (current_pool_ == this) {
+        thread_local std::minstd_rand rng(static_cast<unsigned>(current_index_ + 1));
+        found = pop_local(current_index_, task) || steal(current_index_, rng, task);
+    } else {
+        thread_local std::minstd_rand rng(std::random_device{}());
+        found = steal(queues_.size(), rng, task);
+    }
+
+    if (found) {
+        // Tasks nested in this one already count towards its elapsed time.
+        auto outer_nested = nested_cpu_time_;
+        auto start = thread_cpu_time();
+        run_task(task);
+        nested_cpu_time_ = outer_nested + (thread_cpu_time() - start);
+    }
+    return found;
+}
+
+std::chrono::microseconds ThreadPool::nested_cpu_time() {
+    return nested_cpu_time_;
 }
 
 void ThreadPool::wait_for_all() {
     std::unique_lock<std::mutex> lock(finished_mutex_);
     finished_.wait(lock, [this] {
-        return tasks_.empty() && active_tasks_.load() == 0;
+        return pending_tasks_.load() == 0 && active_tasks_.load() == 0;
     });
 }
 
 void ThreadPool::shutdown() {
-    if (stop_) {
+    if (stop_.exchange(true)) {
         return;
     }
-    
-    Logger::getInstance().info("Shutting down ThreadPool");
-    stop_ = true;
-    
+
+    LOG_INFO("Shutting down ThreadPool");
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(space_mutex_);
+        space_.notify_all();
+    }
+
     for (auto& worker : workers_) {
         if (worker.joinable()) {
             worker.join();
         }
     }
-    
+
     workers_.clear();
 }
 
@@ -64,5 +266,9 @@ size_t ThreadPool::active_count() const {
 }
 
 size_t ThreadPool::pending_count() const {
-    return tasks_.size();
-}
\ No newline at end of file
+    return pending_tasks_.load();
+}
+
+size_t ThreadPool::max_pending() const {
+    return max_pending_;
+}
@@ -1,52 +1,139 @@
 #pragma once
 
 #include "../../include/common.h"
+#include <random>
 
+// Receives futures that are already ready, in the order their tasks
+// finished; see ThreadPool::enqueue_to().
+template<typename T>
+using CompletionQueue = ThreadSafeQueue<std::future<T>>;
+
+// Work-stealing pool: every worker owns a deque, idle workers steal from
+// random victims and park on a condition variable instead of polling.
 class ThreadPool {
 private:
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::atomic<size_t> size{0};
+    };
+
     std::vector<std::thread> workers_;
-    ThreadSafeQueue<std::function<void()>> tasks_;
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
     std::atomic<bool> stop_;
     std::atomic<size_t> active_tasks_;
+    std::atomic<size_t> pending_tasks_;
+    std::atomic<size_t> idle_workers_;
+    std::atomic<size_t> searching_workers_;
+    std::atomic<size_t> next_queue_;
+    size_t max_pending_;
+    QueueFullPolicy full_policy_;
+    std::atomic<size_t> blocked_producers_;
+    std::condition_variable space_;
+    std::mutex space_mutex_;
+    std::condition_variable wake_;
+    std::mutex wake_mutex_;
     std::condition_variable finished_;
     std::mutex finished_mutex_;
-    
+
+    static constexpr size_t kSpinRounds = 16;
+
+    static thread_local ThreadPool* current_pool_;
+    static thread_local size_t current_index_;
+    static thread_local std::chrono::microseconds nested_cpu_time_;
+
 public:
-    explicit ThreadPool(size_t num_threads);
+    // max_pending == 0 keeps the queue unbounded. Otherwise enqueue() from
+    // outside the pool blocks or throws (per policy) while max_pending tasks
+    // are queued; tasks enqueued by workers are never held back, since a
+    // worker blocking on its own pool could deadlock it.
+    explicit ThreadPool(size_t num_threads, size_t max_pending = 0,
+                        QueueFullPolicy policy = QueueFullPolicy::BLOCK);
     ~ThreadPool();
-    
+
     template<class F, class... Args>
-    auto enqueue(F&& f, Args&&... args) 
+    auto enqueue(F&& f, Args&&... args)
         -> std::future<typename std::result_of<F(Args...)>::type> {
-        
+
         using return_type = typename std::result_of<F(Args...)>::type;
-        
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
+        return submit_packaged<return_type>(nullptr, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // Like enqueue(), but instead of returning the future, pushes it to
+    // completed once the task has run, so results (and exceptions, via
+    // get()) can be consumed in completion order. completed must outlive
+    // the task.
+    template<class R, class F, class... Args>
+    void enqueue_to(CompletionQueue<R>& completed, F&& f, Args&&... args) {
+        submit_packaged<R>(&completed, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+    
+    // Runs queued tasks on the calling thread until future is ready. Tasks
+    // that wait on their own subtasks use this instead of future.wait() so
+    // every worker blocking on a subtask cannot starve the pool. Works
+    // for std::future and std::shared_future.
+    template<typename Future>
+    void help_until_ready(const Future& future) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!run_pending_task()) {
+                future.wait_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    bool run_pending_task();
+    
+    // CPU time the calling thread has spent in tasks run through
+    // run_pending_task(), i.e. nested inside whatever it was running. A
+    // task timing itself subtracts how much this grew meanwhile.
+    static std::chrono::microseconds nested_cpu_time();
+    
+    void wait_for_all();
+    void shutdown();
+    size_t size() const;
+    size_t active_count() const;
+    size_t pending_count() const;
+    size_t max_pending() const;
+
+private:
+    // Packages f(args...) and queues it once the pool accepts it. The
+    // task's future is returned, or pushed to completed after the task
+    // has run when completed is given.
+    template<class R, class F, class... Args>
+    std::future<R> submit_packaged(CompletionQueue<R>* completed, F&& f, Args&&... args) {
+        auto task = std::make_shared<std::packaged_task<R()>>(
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
         
-        std::future<return_type> result = task->get_future();
+        std::future<R> result = task->get_future();
         
         if (stop_) {
             throw std::runtime_error("enqueue on stopped ThreadPool");
         }
         
-        tasks_.push([this, task]() {
-            ++active_tasks_;
+        if (!acquire_slot()) {
+            throw std::runtime_error("enqueue on full ThreadPool");
+        }
+        
+        if (!completed) {
+            submit([task]() { (*task)(); });
+            return result;
+        }
+        
+        auto future = std::make_shared<std::future<R>>(std::move(result));
+        submit([task, future, completed]() {
             (*task)();
-            --active_tasks_;
-            finished_.notify_all();
+            completed->push(std::move(*future));
         });
-        
-        return result;
+        return {};
     }
     
-    void wait_for_all();
-    void shutdown();
-    size_t size() const;
-    size_t active_count() const;
-    size_t pending_count() const;
-    
-private:
-    void worker_thread();
-};
\ No newline at end of file
+    bool acquire_slot();
+    void submit(std::function<void()> task);
+    void task_taken();
+    bool pop_local(size_t index, std::function<void()>& task);
+    bool steal(size_t thief, std::minstd_rand& rng, std::function<void()>& task);
+    void run_task(std::function<void()>& task);
+    void wake_one();
+    void worker_thread(size_t index);
+};
@@ -4,8 +4,20 @@
 #include "utils/Timer.h"
 #include "core/ThreadPool.h"
 #include "core/FileProcessor.h"
+#include "core/ProcessorPool.h"
+#include "core/DirectoryWalker.h"
+#include "core/FileBatcher.h"
+#include "core/ReadEngine.h"
+#include "core/Manifest.h"
+#include "core/Deduplicator.h"
+#include "core/DirectoryWatcher.h"
+#include "core/ReportWriter.h"
+#include "core/ResultsStore.h"
 #include "processors/TextProcessor.h"
+#include "processors/CorpusCounter.h"
 #include "observers/ProgressMonitor.h"
+#include <csignal>
+#include <cstring>
 
 void print_help() {
     std::cout << "Multi-threaded File Processing System\n\n";
@@ -15,8 +27,44 @@ void print_help() {
     std::cout << "  -o, --output PATH     Output directory (default: ./output)\n";
     std::cout << "  -t, --threads NUM     Number of worker threads (default: 4)\n";
     std::cout << "  --type TYPE           Processor type: text, image, auto (default: auto)\n";
+    std::cout << "  --input-mode MODE     File input: buffered, mmap, async (default: buffered)\n";
+    std::cout << "  --io-depth NUM        Reads kept in flight in async mode (default: 32)\n";
+    std::cout << "  --io-buffer-bytes N   Max bytes read ahead of analysis in async mode\n";
+    std::cout << "                        (default: 268435456)\n";
+    std::cout << "  --split-threshold N   Split files of at least N bytes across threads\n";
+    std::cout << "                        (default: 67108864, 0 disables)\n";
+    std::cout << "  --schedule POLICY     File order: submission, largest-first, smallest-first\n";
+    std::cout << "                        (default: submission)\n";
+    std::cout << "  --heavy-hitters BYTES Approximate top words in at most BYTES per file\n";
+    std::cout << "                        (default: 0, exact counts)\n";
+    std::cout << "  --batch-bytes N       Run files smaller than N bytes in batches of up to\n";
+    std::cout << "                        N bytes per task (default: 65536, 0 disables)\n";
+    std::cout << "  --batch-files NUM     Max files per batch (default: 64)\n";
+    std::cout << "  --queue-size NUM      Max queued tasks before submission blocks (default: 100)\n";
+    std::cout << "  --max-in-flight NUM   Max tasks submitted but not yet collected\n";
+    std::cout << "                        (default: queue size + threads)\n";
+    std::cout << "  --incremental         Skip files unchanged since the last run, using a\n";
+    std::cout << "                        manifest kept in the output directory\n";
+    std::cout << "  --manifest-hash       Also skip files whose contents match the manifest\n";
+    std::cout << "                        after a touch or copy (reads changed files twice)\n";
+    std::cout << "  --dedup               Analyze identical files once per run and copy the\n";
+    std::cout << "                        report to the others\n";
+    std::cout << "  --report-format FMT   Reports as: files (one per input), ndjson (one\n";
+    std::cout << "                        record per input in OUTPUT/reports.ndjson)\n";
+    std::cout << "                        (default: files)\n";
+    std::cout << "  --results-file PATH   Also write all metrics to a binary results file\n";
+    std::cout << "                        (read it with results_dump)\n";
+    std::cout << "  --corpus-report       Also total word counts over all analyzed files in\n";
+    std::cout << "                        OUTPUT/corpus_analysis.txt (not with --incremental,\n";
+    std::cout << "                        --dedup, --watch or --heavy-hitters)\n";
+    std::cout << "  --corpus-top NUM      Words listed in the corpus report (default: 100)\n";
+    std::cout << "  --watch               Keep running after the first pass and analyze files\n";
+    std::cout << "                        again as they are written, until interrupted\n";
+    std::cout << "  --watch-debounce MS   Wait for MS quiet milliseconds before analyzing a\n";
+    std::cout << "                        changed file (default: 100)\n";
     std::cout << "  -c, --config PATH     Configuration file path\n";
     std::cout << "  -v, --verbose         Enable verbose logging\n";
+    std::cout << "  --log-async BOOL      Write log lines from a background thread (default: true)\n";
     std::cout << "  -s, --stats           Show performance statistics\n";
     std::cout << "  -h, --help            Show this help message\n\n";
     std::cout << "Examples:\n";
@@ -24,40 +72,75 @@ void print_help() {
     std::cout << "  file_processor -i data/files/ -o results/ -v -s\n";
 }
 
-std::vector<std::string> collect_files(const std::string& input_path) {
-    std::vector<std::string> files;
+struct ProcessorOptions {
+    std::string type;
+    std::string output_dir;
+    InputMode input_mode = InputMode::BUFFERED;
+    ThreadPool* pool = nullptr;
+    size_t split_threshold = 0;
+    size_t heavy_hitters_memory = 0;
+    ReportWriter* report_writer = nullptr;
+    CorpusCounter* corpus_counter = nullptr;
+    bool hash_contents = false;
+};
+
+std::unique_ptr<IFileProcessor> create_processor(const ProcessorOptions& options) {
+    auto text_processor = std::make_unique<TextProcessor>(options.output_dir);
+    text_processor->enable_range_splitting(options.pool, options.split_threshold);
+    text_processor->set_heavy_hitters_memory(options.heavy_hitters_memory);
+    text_processor->set_corpus_counter(options.corpus_counter);
     
-    if (fs::is_regular_file(input_path)) {
-        files.push_back(input_path);
-    } else if (fs::is_directory(input_path)) {
-        for (const auto& entry : fs::recursive_directory_iterator(input_path)) {
-            if (entry.is_regular_file()) {
-                files.push_back(entry.path().string());
-            }
-        }
+    std::unique_ptr<IFileProcessor> processor = std::move(text_processor);
+    processor->set_input_mode(options.input_mode);
+    processor->set_report_writer(options.report_writer);
+    processor->set_content_hashing(options.hash_contents);
+    return processor;
+}
+
+InputMode parse_input_mode(const std::string& mode) {
+    if (mode == "mmap") {
+        return InputMode::MMAP;
     }
-    
-    return files;
+    if (mode == "async") {
+        return InputMode::ASYNC;
+    }
+    if (mode != "buffered") {
+        LOG_WARNING("Unknown input mode '{}', using buffered", mode);
+    }
+    return InputMode::BUFFERED;
 }
 
-size_t calculate_total_size(const std::vector<std::string>& files) {
-    size_t total = 0;
-    for (const auto& file : files) {
-        try {
-            total += fs::file_size(file);
-        } catch (const std::exception& e) {
-            Logger::getInstance().warning("Cannot get size of file: " + file);
-        }
+ReportFormat parse_report_format(const std::string& format) {
+    if (format == "ndjson") {
+        return ReportFormat::NDJSON;
     }
-    return total;
+    if (format != "files") {
+        LOG_WARNING("Unknown report format '{}', using files", format);
+    }
+    return ReportFormat::FILES;
 }
 
-std::unique_ptr<IFileProcessor> create_processor(const std::string& type, const std::string& output_dir) {
-    if (type == "text") {
-        return std::make_unique<TextProcessor>(output_dir);
+SchedulePolicy parse_schedule_policy(const std::string& policy) {
+    if (policy == "largest-first" || policy == "lpt") {
+        return SchedulePolicy::LARGEST_FIRST;
+    }
+    if (policy == "smallest-first") {
+        return SchedulePolicy::SMALLEST_FIRST;
+    }
+    if (policy != "submission") {
+        LOG_WARNING("Unknown schedule policy '{}', using submission order", policy);
+    }
+    return SchedulePolicy::SUBMISSION;
+}
+
+// Set while --watch is waiting for changes; SIGINT and SIGTERM end the
+// watch so the run finishes with its usual summary.
+DirectoryWatcher* active_watcher = nullptr;
+
+void stop_watching(int) {
+    if (active_watcher) {
+        active_watcher->stop();
     }
-    
-    return std::make_unique<TextProcessor>(output_dir);
 }
 
 ProcessorType determine_processor_type(const std::string& filepath) {
@@ -97,93 +180,478 @@ int main(int argc, char* argv[]) {
         }
         
         Logger& logger = Logger::getInstance();
+        if (config.has("logging.file")) {
+            logger.setLogFile(config.get<std::string>("logging.file"));
+        }
+        if (config.get<bool>("logging.rotation", false)) {
+            logger.setRotation(config.getBytes("logging.max_file_size"));
+        }
         if (config.get<bool>("verbose")) {
             logger.setLevel(LogLevel::DEBUG);
             logger.setConsoleOutput(true);
         }
+        logger.setAsync(config.get<bool>("log-async", config.get<bool>("logging.async", true)));
         
         std::string input_path = config.get<std::string>("input");
         std::string output_dir = config.get<std::string>("output", "./output");
         int num_threads = config.get<int>("threads", 4);
         std::string processor_type = config.get<std::string>("type", "auto");
+        InputMode input_mode = parse_input_mode(
+            config.get<std::string>("input-mode", config.get<std::string>("processing.input_mode", "buffered")));
         bool show_stats = config.get<bool>("stats", false);
         bool verbose = config.get<bool>("verbose", false);
+        size_t split_threshold = config.get<size_t>("split-threshold",
+            config.get<size_t>("processing.split_threshold", size_t(64) << 20));
+        size_t heavy_hitters_memory = config.get<size_t>("heavy-hitters",
+            config.get<size_t>("processors.text.heavy_hitters_memory", 0));
+        SchedulePolicy schedule = parse_schedule_policy(
+            config.get<std::string>("schedule", config.get<std::string>("processing.schedule", "submission")));
+        size_t batch_bytes = config.get<size_t>("batch-bytes",
+            config.get<size_t>("processing.batch_bytes", 64 * 1024));
+        size_t batch_files = config.get<size_t>("batch-files",
+            config.get<size_t>("processing.batch_files", 64));
+        size_t io_depth = config.get<size_t>("io-depth", config.get<size_t>("processing.io_depth", 32));
+        size_t io_buffer_bytes = config.get<size_t>("io-buffer-bytes",
+            config.get<size_t>("processing.io_buffer_bytes", size_t(256) << 20));
+        int queue_size = config.get<int>("queue-size", config.get<int>("processing.queue_size", 100));
+        int max_in_flight = config.get<int>("max-in-flight", queue_size + num_threads);
+        bool incremental = config.get<bool>("incremental", config.get<bool>("processing.incremental", false));
+        bool manifest_hash = config.get<bool>("manifest-hash", config.get<bool>("processing.manifest_hash", false));
+        bool dedup = config.get<bool>("dedup", config.get<bool>("processing.dedup", false));
+        ReportFormat report_format = parse_report_format(
+            config.get<std::string>("report-format", config.get<std::string>("output.report_format", "files")));
+        std::string results_file = config.get<std::string>("results-file",
+            config.get<std::string>("output.results_file", ""));
+        bool corpus_report = config.get<bool>("corpus-report", config.get<bool>("output.corpus_report", false));
+        size_t corpus_top_words = config.get<size_t>("corpus-top",
+            config.get<size_t>("output.corpus_top_words", 100));
+        bool watch = config.get<bool>("watch", config.get<bool>("processing.watch", false));
+        int watch_debounce_ms = config.get<int>("watch-debounce",
+            config.get<int>("processing.watch_debounce_ms", 100));
+        max_in_flight = std::max(max_in_flight, 1);
+        
+        // The corpus totals are only correct when every file is analyzed
+        // exactly once with exact counts: skipped files, shared duplicate
+        // results, re-analyzed files and approximate summaries would all
+        // make them wrong.
+        if (corpus_report && (incremental || dedup || watch || heavy_hitters_memory > 0)) {
+            LOG_ERROR("--corpus-report cannot be combined with --incremental, --dedup, --watch "
+                      "or --heavy-hitters");
+            return 1;
+        }
         
-        logger.info("Starting file processing system");
-        logger.info("Input: " + input_path);
-        logger.info("Output: " + output_dir);
-        logger.info("Threads: " + std::to_string(num_threads));
+        LOG_INFO("Starting file processing system");
+        LOG_INFO("Input: {}", input_path);
+        LOG_INFO("Output: {}", output_dir);
+        LOG_INFO("Threads: {}", num_threads);
         
         fs::create_directories(output_dir);
         
-        std::vector<std::string> files = collect_files(input_path);
-        if (files.empty()) {
-            logger.error("No files found to process");
+        auto progress_monitor = std::make_shared<ProgressMonitor>(verbose);
+        progress_monitor->start_rendering();
+        
+        ProcessingStats stats;
+        
+        ProcessorOptions processor_options;
+        processor_options.type = processor_type;
+        processor_options.output_dir = output_dir;
+        processor_options.input_mode = input_mode;
+        processor_options.split_threshold = split_threshold;
+        processor_options.heavy_hitters_memory = heavy_hitters_memory;
+        // The manifest takes content hashes from the results; the
+        // Deduplicator already hashes every file it sees.
+        processor_options.hash_contents = incremental && manifest_hash && !dedup;
+        
+        // Only settings that change the reports are part of the manifest's
+        // key; input mode, threads and scheduling do not.
+        std::unique_ptr<Manifest> manifest;
+        bool manifest_loaded = false;
+        if (incremental) {
+            std::string settings = "type=" + processor_type +
+                                   ";heavy_hitters_memory=" + std::to_string(heavy_hitters_memory);
+            if (report_format == ReportFormat::NDJSON) {
+                settings += ";reports=ndjson";
+            }
+            manifest = std::make_unique<Manifest>(
+                (fs::path(output_dir) / ".file_processor_manifest").string(), settings, manifest_hash);
+            if (manifest->load()) {
+                manifest_loaded = true;
+                LOG_INFO("Loaded manifest with {} files", manifest->size());
+            }
+        }
+        
+        // Every result, including ones taken over from the manifest, goes
+        // into the results file, which is rewritten after each pass.
+        std::unique_ptr<ResultsStore> results_store;
+        if (!results_file.empty()) {
+            results_store = std::make_unique<ResultsStore>(results_file);
+        }
+        
+        // Workers only format reports; one thread writes them. The stream is
+        // rewritten on every run; files the manifest lets us skip get their
+        // record from the previous stream.
+        ReportWriter report_writer;
+        if (report_format == ReportFormat::NDJSON &&
+            !report_writer.open_stream((fs::path(output_dir) / "reports.ndjson").string(), manifest_loaded)) {
             return 1;
         }
+        processor_options.report_writer = &report_writer;
+        
+        // Every processor adds its files' word counts to one sharded table
+        // as it goes, so the totals are complete when the last file is.
+        std::unique_ptr<CorpusCounter> corpus_counter;
+        if (corpus_report) {
+            corpus_counter = std::make_unique<CorpusCounter>();
+            processor_options.corpus_counter = corpus_counter.get();
+        }
         
-        logger.info("Found " + std::to_string(files.size()) + " files to process");
+        // One processor per concurrently running file, reused for the rest
+        // of the run rather than built per file. It, the report writer, the
+        // completion queue and the read engine are declared before the pool
+        // so they outlive any task the pool drains on shutdown.
+        CompletionQueue<std::vector<ProcessResult>> completed;
+        ProcessorPool processors([&processor_options, &progress_monitor]() {
+            auto processor = create_processor(processor_options);
+            processor->attach_progress_observer(progress_monitor);
+            return processor;
+        });
         
-        size_t total_size = calculate_total_size(files);
+        // Async mode reads whole files ahead of the workers, which then only
+        // analyze. Files that get split into ranges are still read by their
+        // range tasks.
+        std::unique_ptr<ReadEngine> read_engine;
+        if (input_mode == InputMode::ASYNC) {
+            read_engine = ReadEngine::create(io_depth, io_buffer_bytes);
+            LOG_INFO("Async reads via {}, depth {}", read_engine->name(), io_depth);
+        }
         
-        auto progress_monitor = std::make_shared<ProgressMonitor>(verbose);
-        progress_monitor->set_totals(files.size(), total_size);
+        std::unique_ptr<Deduplicator> deduplicator;
         
-        ThreadPool thread_pool(num_threads);
-        ProcessingStats stats;
+        ThreadPool thread_pool(num_threads, std::max(queue_size, 0));
+        processor_options.pool = &thread_pool;
+        if (dedup) {
+            deduplicator = std::make_unique<Deduplicator>(thread_pool, split_threshold);
+        }
+        
+        // Directories are scanned on the pool while files found so far are
+        // already being processed.
+        DirectoryWalker walker(thread_pool);
+        
+        // The watch is set up before the first pass, so files written while
+        // it runs are analyzed again once it is done.
+        std::unique_ptr<DirectoryWatcher> watcher;
+        if (watch) {
+            watcher = std::make_unique<DirectoryWatcher>(std::chrono::milliseconds(std::max(watch_debounce_ms, 0)));
+            watcher->ignore(output_dir);
+            if (!watcher->watch(input_path)) {
+                return 1;
+            }
+        }
         
         Timer total_timer;
         total_timer.start();
+        walker.start(input_path);
         
-        std::vector<std::future<ProcessResult>> futures;
+        // Results are collected in completion order while files are still
+        // being submitted, so at most max_in_flight tasks (single files or
+        // batches) are outstanding and a slow file never holds up the
+        // results behind it.
+        size_t outstanding = 0;
         
-        for (const auto& file : files) {
-            auto processor = create_processor(processor_type, output_dir);
-            processor->attach_progress_observer(progress_monitor);
+        auto collect_result = [&]() {
+            std::future<std::vector<ProcessResult>> future;
+            completed.wait_and_pop(future);
+            --outstanding;
             
-            auto future = thread_pool.enqueue([processor = std::move(processor), file]() {
-                return processor->process(file);
-            });
-            
-            futures.push_back(std::move(future));
-        }
-        
-        for (auto& future : futures) {
             try {
-                ProcessResult result = future.get();
-                stats.files_processed++;
-                stats.bytes_processed += result.bytes_processed;
-                
-                if (!result.success) {
-                    stats.errors++;
-                    logger.error("Processing failed: " + result.message);
+                for (const ProcessResult& result : future.get()) {
+                    stats.files_processed++;
+                    stats.bytes_processed += result.bytes_processed;
+                    
+                    if (!result.success) {
+                        stats.errors++;
+                        LOG_ERROR("Processing failed: {}", result.message);
+                    }
+                    if (manifest) {
+                        manifest->record(result);
+                    }
+                    if (results_store) {
+                        results_store->add(result);
+                    }
                 }
             } catch (const std::exception& e) {
                 stats.errors++;
-                logger.error("Task execution failed: " + std::string(e.what()));
+                LOG_ERROR("Task execution failed: {}", e.what());
+            }
+        };
+        
+        std::chrono::steady_clock::time_point first_submit;
+        
+        auto submit_task = [&](std::vector<std::string> files, size_t bytes) {
+            if (outstanding >= static_cast<size_t>(max_in_flight)) {
+                collect_result();
+            }
+            if (first_submit == std::chrono::steady_clock::time_point{}) {
+                first_submit = std::chrono::steady_clock::now();
+            }
+            
+            if (read_engine && (split_threshold == 0 || bytes < split_threshold)) {
+                read_engine->wait_for_buffer_space(bytes);
+                std::vector<std::future<ReadBuffer>> reads;
+                reads.reserve(files.size());
+                for (const auto& file : files) {
+                    reads.push_back(read_engine->read(file));
+                }
+                
+                thread_pool.enqueue_to(completed, [&processors, &stats, &deduplicator, files = std::move(files),
+                                                   reads = std::move(reads)]() mutable {
+                    auto start = thread_cpu_time();
+                    auto nested_start = ThreadPool::nested_cpu_time();
+                    auto processor = processors.acquire();
+                    
+                    std::vector<ProcessResult> results;
+                    results.reserve(files.size());
+                    for (size_t i = 0; i < files.size(); ++i) {
+                        ReadBuffer buffer = reads[i].get();
+                        if (buffer.error() != 0) {
+                            ProcessResult failed;
+                            failed.input_path = files[i];
+                            failed.message = "Error reading file: " + files[i] + " (" +
+                                             std::strerror(buffer.error()) + ")";
+                            results.push_back(std::move(failed));
+                        } else if (deduplicator) {
+                            results.push_back(deduplicator->process_contents(*processor, files[i], buffer.view()));
+                        } else {
+                            results.push_back(processor->process_contents(files[i], buffer.view()));
+                        }
+                    }
+                    
+                    stats.record_task(thread_cpu_time() - start - (ThreadPool::nested_cpu_time() - nested_start));
+                    return results;
+                });
+                ++outstanding;
+                return;
+            }
+            
+            thread_pool.enqueue_to(completed, [&processors, &stats, &deduplicator, files = std::move(files)]() {
+                auto start = thread_cpu_time();
+                auto nested_start = ThreadPool::nested_cpu_time();
+                auto processor = processors.acquire();
+                
+                std::vector<ProcessResult> results;
+                results.reserve(files.size());
+                for (const auto& file : files) {
+                    results.push_back(deduplicator ? deduplicator->process(*processor, file) : processor->process(file));
+                }
+                
+                stats.record_task(thread_cpu_time() - start - (ThreadPool::nested_cpu_time() - nested_start));
+                return results;
+            });
+            ++outstanding;
+        };
+        
+        FileBatcher batcher(batch_bytes, batch_files, submit_task);
+        
+        // Unchanged files keep their previous result and never reach the pool.
+        auto skip_unchanged = [&](const DirectoryWalker::Entry& entry) {
+            if (!manifest) {
+                return false;
+            }
+            
+            Manifest::FileState state;
+            state.size = entry.size;
+            state.mtime_ns = entry.mtime_ns;
+            state.device = entry.device;
+            state.inode = entry.inode;
+            
+            ProcessResult previous;
+            if (!manifest->reuse(entry.path, state, previous)) {
+                return false;
+            }
+            // A file whose record is missing from the previous stream is
+            // analyzed again rather than left out of the new one.
+            if (report_format == ReportFormat::NDJSON && !report_writer.carry_over(entry.path)) {
+                return false;
+            }
+            stats.files_skipped++;
+            stats.bytes_skipped += entry.size;
+            if (results_store) {
+                results_store->add(previous);
+            }
+            return true;
+        };
+        
+        DirectoryWalker::Entry entry;
+        if (schedule == SchedulePolicy::SUBMISSION) {
+            while (walker.next(entry)) {
+                if (skip_unchanged(entry)) {
+                    continue;
+                }
+                progress_monitor->add_totals(1, entry.size);
+                batcher.add(std::move(entry.path), entry.size);
+            }
+        } else {
+            // Size-ordered policies need the whole list before the first
+            // submission; the scan itself still runs in parallel.
+            std::vector<DirectoryWalker::Entry> entries;
+            while (walker.next(entry)) {
+                if (skip_unchanged(entry)) {
+                    continue;
+                }
+                progress_monitor->add_totals(1, entry.size);
+                entries.push_back(std::move(entry));
+            }
+            
+            DirectoryWalker::order_for_schedule(entries, schedule);
+            for (auto& file : entries) {
+                batcher.add(std::move(file.path), file.size);
+            }
+        }
+        batcher.flush();
+        
+        while (outstanding > 0) {
+            collect_result();
+        }
+        report_writer.flush();
+        report_writer.drop_previous();
+        
+        if (walker.files_found() == 0 && !watch) {
+            LOG_ERROR("No files found to process");
+            return 1;
+        }
+        
+        LOG_INFO("Found {} files to process ({} hard-linked duplicates skipped)",
+                 walker.files_found(), walker.duplicates_skipped());
+        
+        if (deduplicator) {
+            LOG_INFO("Deduplication: {} identical files shared a result, {} bytes not analyzed",
+                     deduplicator->duplicates(), deduplicator->bytes_saved());
+        }
+        
+        if (manifest) {
+            LOG_INFO("Incremental run: {} files ({} bytes) processed, {} unchanged files ({} bytes) skipped",
+                     stats.files_processed.load(), stats.bytes_processed.load(),
+                     stats.files_skipped.load(), stats.bytes_skipped.load());
+            manifest->save();
+        }
+        
+        if (results_store && results_store->save()) {
+            LOG_INFO("Wrote results for {} files to {}", results_store->size(), results_store->path());
+        }
+        
+        if (corpus_counter) {
+            std::string corpus_report_path = (fs::path(output_dir) / "corpus_analysis.txt").string();
+            if (ReportWriter::write_file(corpus_report_path, corpus_counter->format_report(corpus_top_words))) {
+                LOG_INFO("Corpus: {} words, {} distinct, in {} files", corpus_counter->total_words(),
+                         corpus_counter->distinct_words(), corpus_counter->files());
+            } else {
+                LOG_ERROR("Cannot write corpus report {}", corpus_report_path);
             }
         }
         
         total_timer.stop();
         stats.end_time = std::chrono::steady_clock::now();
         
+        double achieved_makespan = std::chrono::duration<double>(stats.end_time - first_submit).count();
+        // Workers beyond the core count cannot shorten the run.
+        size_t parallelism = std::min<size_t>(thread_pool.size(),
+            std::max(std::thread::hardware_concurrency(), 1u));
+        double ideal_makespan = stats.get_ideal_makespan_seconds(parallelism);
+        LOG_INFO("Makespan: {}s achieved, {}s ideal", achieved_makespan, ideal_makespan);
+        
+        // Watch mode keeps the pool, processors and observers of the first
+        // pass and only submits the files that changed since.
+        if (watch) {
+            active_watcher = watcher.get();
+            std::signal(SIGINT, stop_watching);
+            std::signal(SIGTERM, stop_watching);
+            LOG_INFO("Watching {} ({} directories) for changes", input_path, watcher->directories());
+            
+            std::vector<std::string> changed;
+            while (watcher->wait(changed)) {
+                auto batch_start = std::chrono::steady_clock::now();
+                if (deduplicator) {
+                    deduplicator->clear();
+                }
+                
+                size_t submitted = 0;
+                size_t failed_before = stats.errors.load();
+                for (const auto& path : changed) {
+                    DirectoryWalker::Entry changed_entry;
+                    if (!DirectoryWalker::stat_file(path, changed_entry) || skip_unchanged(changed_entry)) {
+                        continue;
+                    }
+                    progress_monitor->add_totals(1, changed_entry.size);
+                    batcher.add(std::move(changed_entry.path), changed_entry.size);
+                    ++submitted;
+                }
+                batcher.flush();
+                
+                while (outstanding > 0) {
+                    collect_result();
+                }
+                report_writer.flush();
+                if (manifest && submitted > 0) {
+                    manifest->save();
+                }
+                if (results_store && submitted > 0) {
+                    results_store->save();
+                }
+                
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - batch_start);
+                LOG_INFO("Analyzed {} of {} changed files in {} ms ({} failed)", submitted, changed.size(),
+                         elapsed.count(), stats.errors.load() - failed_before);
+                changed.clear();
+            }
+            
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            active_watcher = nullptr;
+            LOG_INFO("Stopped watching {}", input_path);
+        }
+        
+        progress_monitor->stop_rendering();
         progress_monitor->print_summary();
         
         if (show_stats) {
             std::cout << "\n=== Performance Statistics ===\n";
-            std::cout << "Total files: " << files.size() << "\n";
+            std::cout << "Total files: " << walker.files_found() << "\n";
             std::cout << "Successfully processed: " << stats.files_processed.load() << "\n";
             std::cout << "Errors: " << stats.errors.load() << "\n";
-            std::cout << "Total bytes: " << total_size << "\n";
+            std::cout << "Total bytes: " << walker.bytes_found() << "\n";
+            if (manifest) {
+                std::cout << "Processed bytes: " << stats.bytes_processed.load() << "\n";
+                std::cout << "Skipped (unchanged): " << stats.files_skipped.load() << " files, "
+                          << stats.bytes_skipped.load() << " bytes\n";
+            }
+            if (deduplicator) {
+                std::cout << "Deduplicated: " << deduplicator->duplicates() << " files, "
+                          << deduplicator->bytes_saved() << " bytes saved\n";
+            }
             std::cout << "Processing time: " << total_timer.elapsed_seconds() << " seconds\n";
             std::cout << "Throughput: " << stats.get_throughput_mbps() << " MB/s\n";
             std::cout << "Threads used: " << num_threads << "\n";
+            std::cout << "Makespan: " << achieved_makespan << " seconds achieved, "
+                      << ideal_makespan << " seconds ideal";
+            if (achieved_makespan > 0) {
+                std::ios_base::fmtflags flags = std::cout.flags();
+                std::streamsize precision = std::cout.precision();
+                std::cout << " (" << std::fixed << std::setprecision(1)
+                          << ideal_makespan / achieved_makespan * 100.0 << "% balanced)";
+                std::cout.flags(flags);
+                std::cout.precision(precision);
+            }
+            std::cout << "\n";
             std::cout << "===============================\n";
         }
         
-        logger.info("File processing completed");
+        if (report_writer.write_errors() > 0) {
+            LOG_ERROR("{} analysis reports could not be written", report_writer.write_errors());
+        }
+        LOG_INFO("File processing completed");
         
-        return stats.errors.load() > 0 ? 1 : 0;
+        return stats.errors.load() > 0 || report_writer.write_errors() > 0 ? 1 : 0;
         
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../../include/common.h"
+#include "../utils/Logger.h"
+#include <iterator>
 
 template<typename EventType>
 class Observer {
@@ -9,68 +11,187 @@ public:
     virtual void notify(const EventType& event) = 0;
 };
 
+// Observers are kept in an immutable list that is replaced, never edited:
+// attach and detach copy it under writers_mutex_ and publish the copy, and
+// notify_all only loads the current list, so notifying threads never block
+// each other or a writer. Replaced lists are retired and freed by a writer
+// that sees no notification in progress; a notifier announces itself in
+// active_notifiers_ before loading the list, so it either holds the count
+// up or already sees the newer list.
+//
+// The subject holds one strong reference per observer, in refs_, and the
+// lists point at those, which saves a weak_ptr::lock() per observer per
+// event. An observer nobody else owns any more therefore counts as
+// expired however many lists are alive: it is skipped and pruned, and its
+// reference is retired along with the lists that may still point at it.
 template<typename EventType>
 class Subject {
 private:
-    std::vector<std::weak_ptr<Observer<EventType>>> observers_;
-    mutable std::mutex observers_mutex_;
+    using ObserverPtr = std::shared_ptr<Observer<EventType>>;
+    using ObserverRef = std::unique_ptr<const ObserverPtr>;
+    using ObserverList = std::vector<const ObserverPtr*>;
     
+    std::atomic<const ObserverList*> observers_{nullptr};
+    mutable std::atomic<size_t> active_notifiers_{0};
+    
+    std::mutex writers_mutex_;
+    std::vector<ObserverRef> refs_;
+    std::unique_ptr<const ObserverList> current_;
+    std::vector<std::unique_ptr<const ObserverList>> retired_;
+    std::vector<ObserverRef> retired_refs_;
+    
+    static bool expired(const ObserverPtr& observer) {
+        return observer.use_count() <= 1;
+    }
+    
+    // Requires writers_mutex_. Retires the references of expired observers
+    // and of those matching drop.
+    template<typename Drop>
+    void retire_if(Drop&& drop) {
+        auto kept = std::stable_partition(refs_.begin(), refs_.end(), [&drop](const ObserverRef& ref) {
+            return !expired(*ref) && !drop(*ref);
+        });
+        std::move(kept, refs_.end(), std::back_inserter(retired_refs_));
+        refs_.erase(kept, refs_.end());
+    }
+    
+    // Requires writers_mutex_.
+    void publish() {
+        auto next = std::make_unique<ObserverList>();
+        next->reserve(refs_.size());
+        for (const ObserverRef& ref : refs_) {
+            next->push_back(ref.get());
+        }
+        
+        observers_.store(next.get());
+        if (current_) {
+            retired_.push_back(std::move(current_));
+        }
+        current_ = std::move(next);
+        
+        if (active_notifiers_.load() == 0) {
+            retired_.clear();
+            retired_refs_.clear();
+        }
+    }
+    
+    void prune() {
+        std::unique_lock<std::mutex> lock(writers_mutex_, std::try_to_lock);
+        if (lock.owns_lock()) {
+            retire_if([](const ObserverPtr&) { return false; });
+            publish();
+        }
+    }
+
 public:
+    Subject() = default;
+    Subject(const Subject&) = delete;
+    Subject& operator=(const Subject&) = delete;
+    
     void attach(std::shared_ptr<Observer<EventType>> observer) {
-        std::lock_guard<std::mutex> lock(observers_mutex_);
-        observers_.push_back(observer);
+        std::lock_guard<std::mutex> lock(writers_mutex_);
+        retire_if([](const ObserverPtr&) { return false; });
+        refs_.push_back(std::make_unique<const ObserverPtr>(std::move(observer)));
+        publish();
     }
     
     void detach(std::shared_ptr<Observer<EventType>> observer) {
-        std::lock_guard<std::mutex> lock(observers_mutex_);
-        observers_.erase(
-            std::remove_if(observers_.begin(), observers_.end(),
-                [&observer](const std::weak_ptr<Observer<EventType>>& weak_obs) {
-                    return weak_obs.expired() || weak_obs.lock() == observer;
-                }),
-            observers_.end()
-        );
+        std::lock_guard<std::mutex> lock(writers_mutex_);
+        retire_if([&observer](const ObserverPtr& attached) { return attached == observer; });
+        publish();
     }
     
     void notify_all(const EventType& event) {
-        std::lock_guard<std::mutex> lock(observers_mutex_);
+        active_notifiers_.fetch_add(1);
+        const ObserverList* observers = observers_.load();
         
-        auto it = observers_.begin();
-        while (it != observers_.end()) {
-            if (auto observer = it->lock()) {
+        bool saw_expired = false;
+        if (observers) {
+            for (const ObserverPtr* observer : *observers) {
+                if (expired(*observer)) {
+                    saw_expired = true;
+                    continue;
+                }
                 try {
-                    observer->notify(event);
-                    ++it;
+                    (*observer)->notify(event);
                 } catch (const std::exception& e) {
-                    Logger::getInstance().error("Observer notification failed: " + std::string(e.what()));
-                    ++it;
+                    LOG_ERROR("Observer notification failed: {}", e.what());
                 }
-            } else {
-                it = observers_.erase(it);
             }
         }
+        
+        active_notifiers_.fetch_sub(1);
+        if (saw_expired) {
+            prune();
+        }
     }
     
     size_t observer_count() const {
-        std::lock_guard<std::mutex> lock(observers_mutex_);
-        return std::count_if(observers_.begin(), observers_.end(),
-            [](const std::weak_ptr<Observer<EventType>>& weak_obs) {
-                return !weak_obs.expired();
-            });
+        active_notifiers_.fetch_add(1);
+        const ObserverList* observers = observers_.load();
+        size_t count = observers ? std::count_if(observers->begin(), observers->end(),
+            [](const ObserverPtr* observer) { return !expired(*observer); }) : 0;
+        active_notifiers_.fetch_sub(1);
+        return count;
     }
 };
 
+enum class ProgressStatus : uint8_t {
+    STARTED,
+    PROCESSING,
+    COMPLETED,
+    FAILED
+};
+
+// Small and trivially copyable so that sending one costs no allocation.
+// bytes is what was processed since the previous event for the same file,
+// so observers can sum it without tracking files.
 struct ProgressEvent {
-    std::string filename;
-    size_t bytes_processed;
-    size_t total_bytes;
-    double percentage;
-    std::string status;
-    std::chrono::steady_clock::time_point timestamp;
+    uint64_t file_id;
+    uint64_t bytes;
+    uint64_t total_bytes;
+    ProgressStatus status;
+};
+
+static_assert(std::is_trivially_copyable_v<ProgressEvent>);
+
+// Batches PROCESSING events for one file, or for one range of it when
+// several threads work on the same file; each thread uses its own
+// reporter. Bytes are sent once at least kMinBytes are pending and
+// kInterval has passed since the last event, or once kMaxBytes are
+// pending. Pending bytes that are never sent are covered by the file's
+// final event, which carries whatever was not yet reported.
+class ProgressReporter {
+public:
+    static constexpr size_t kMinBytes = 64 * 1024;
+    static constexpr size_t kMaxBytes = 4 * 1024 * 1024;
+    static constexpr std::chrono::milliseconds kInterval{50};
+    
+    ProgressReporter(Subject<ProgressEvent>& subject, uint64_t file_id, uint64_t total_bytes,
+                     std::atomic<uint64_t>& reported)
+        : subject_(subject), reported_(reported), file_id_(file_id), total_bytes_(total_bytes),
+          pending_(0), last_sent_(std::chrono::steady_clock::now()) {}
     
-    ProgressEvent(const std::string& file, size_t processed, size_t total, const std::string& stat)
-        : filename(file), bytes_processed(processed), total_bytes(total), 
-          status(stat), timestamp(std::chrono::steady_clock::now()) {
-        percentage = total > 0 ? (static_cast<double>(processed) / total) * 100.0 : 0.0;
+    void advance(size_t bytes) {
+        pending_ += bytes;
+        if (pending_ < kMinBytes) {
+            return;
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        if (pending_ >= kMaxBytes || now - last_sent_ >= kInterval) {
+            reported_.fetch_add(pending_, std::memory_order_relaxed);
+            subject_.notify_all(ProgressEvent{file_id_, pending_, total_bytes_, ProgressStatus::PROCESSING});
+            pending_ = 0;
+            last_sent_ = now;
+        }
     }
-};
\ No newline at end of file
+
+private:
+    Subject<ProgressEvent>& subject_;
+    std::atomic<uint64_t>& reported_;
+    uint64_t file_id_;
+    uint64_t total_bytes_;
+    uint64_t pending_;
+    std::chrono::steady_clock::time_point last_sent_;
+};
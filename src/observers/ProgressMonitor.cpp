@@ -1,24 +1,34 @@
 #include "ProgressMonitor.h"
 #include "../utils/Logger.h"
 
+namespace {
+
+// Each thread keeps to one slot, so concurrent notifiers rarely share a
+// cache line.
+size_t thread_slot() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+}
+
 ProgressMonitor::ProgressMonitor(bool verbose) 
-    : total_files_(0), completed_files_(0), total_bytes_(0), processed_bytes_(0),
-      start_time_(std::chrono::steady_clock::now()), verbose_(verbose) {}
+    : total_files_(0), total_bytes_(0), start_time_(std::chrono::steady_clock::now()),
+      verbose_(verbose), rendering_(false) {}
+
+ProgressMonitor::~ProgressMonitor() {
+    stop_rendering();
+}
 
 void ProgressMonitor::notify(const ProgressEvent& event) {
-    processed_bytes_ += event.bytes_processed;
-    
-    if (event.status == "completed") {
-        ++completed_files_;
-    }
+    Counters& counters = counters_[thread_slot() % kSlots];
+    counters.bytes.fetch_add(event.bytes, std::memory_order_relaxed);
     
-    if (verbose_) {
-        Logger::getInstance().info("Processing: " + event.filename + " (" + 
-                                 std::to_string(event.percentage) + "%)");
-    }
-    
-    if (!verbose_) {
-        print_progress_bar();
+    if (event.status == ProgressStatus::COMPLETED) {
+        counters.completed.fetch_add(1, std::memory_order_relaxed);
+    } else if (event.status == ProgressStatus::FAILED) {
+        counters.failed.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -27,20 +37,95 @@ void ProgressMonitor::set_totals(size_t files, size_t bytes) {
     total_bytes_ = bytes;
 }
 
+void ProgressMonitor::add_totals(size_t files, size_t bytes) {
+    total_files_ += files;
+    total_bytes_ += bytes;
+}
+
+void ProgressMonitor::start_rendering(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(render_mutex_);
+    if (verbose_ || rendering_) {
+        return;
+    }
+    rendering_ = true;
+    render_thread_ = std::thread(&ProgressMonitor::render_loop, this, interval);
+}
+
+void ProgressMonitor::stop_rendering() {
+    {
+        std::lock_guard<std::mutex> lock(render_mutex_);
+        if (!rendering_) {
+            return;
+        }
+        rendering_ = false;
+    }
+    render_wakeup_.notify_all();
+    render_thread_.join();
+    print_progress_bar();
+}
+
+void ProgressMonitor::render_loop(std::chrono::milliseconds interval) {
+    Totals drawn;
+    size_t drawn_total_files = 0;
+    bool first = true;
+    
+    std::unique_lock<std::mutex> lock(render_mutex_);
+    while (rendering_) {
+        lock.unlock();
+        
+        // Skip the redraw while nothing moved.
+        Totals current = totals();
+        size_t total_files = total_files_.load();
+        if (first || current.bytes != drawn.bytes || current.completed != drawn.completed ||
+            total_files != drawn_total_files) {
+            print_progress_bar();
+            drawn = current;
+            drawn_total_files = total_files;
+            first = false;
+        }
+        
+        lock.lock();
+        render_wakeup_.wait_for(lock, interval, [this] { return !rendering_; });
+    }
+}
+
+ProgressMonitor::Totals ProgressMonitor::totals() const {
+    Totals sum;
+    for (const Counters& counters : counters_) {
+        sum.bytes += counters.bytes.load(std::memory_order_relaxed);
+        sum.completed += counters.completed.load(std::memory_order_relaxed);
+        sum.failed += counters.failed.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+size_t ProgressMonitor::completed_files() const {
+    return totals().completed;
+}
+
+size_t ProgressMonitor::processed_bytes() const {
+    return totals().bytes;
+}
+
 void ProgressMonitor::print_summary() const {
     auto now = std::chrono::steady_clock::now();
     double duration = std::chrono::duration<double>(now - start_time_).count();
     
+    Totals done = totals();
+    
     std::lock_guard<std::mutex> lock(display_mutex_);
     
     std::cout << "\n=== Processing Summary ===\n";
-    std::cout << "Files processed: " << completed_files_.load() << "/" << total_files_.load() << "\n";
-    std::cout << "Bytes processed: " << format_bytes(processed_bytes_.load()) << "/" 
+    std::cout << "Files processed: " << done.completed << "/" << total_files_.load() << "\n";
+    if (done.failed > 0) {
+        std::cout << "Files failed: " << done.failed << "\n";
+    }
+    std::cout << "Bytes processed: " << format_bytes(done.bytes) << "/" 
               << format_bytes(total_bytes_.load()) << "\n";
     std::cout << "Duration: " << format_duration(duration) << "\n";
     
     if (duration > 0) {
-        double throughput = processed_bytes_.load() / (1024.0 * 1024.0) / duration;
+        double throughput = done.bytes / (1024.0 * 1024.0) / duration;
         std::cout << "Throughput: " << std::fixed << std::setprecision(2) 
                   << throughput << " MB/s\n";
     }
@@ -48,17 +133,20 @@ void ProgressMonitor::print_summary() const {
     std::cout << "==========================\n";
 }
 
+// The bar follows bytes, which advance within large files; the file count
+// only moves as files finish.
 void ProgressMonitor::print_progress_bar() const {
-    std::lock_guard<std::mutex> lock(display_mutex_);
+    Totals done = totals();
+    size_t total_files = total_files_.load();
+    size_t total_bytes = total_bytes_.load();
     
-    double file_progress = total_files_.load() > 0 ? 
-        static_cast<double>(completed_files_.load()) / total_files_.load() * 100.0 : 0.0;
+    double byte_progress = total_bytes > 0 ? 
+        std::min(static_cast<double>(done.bytes) / total_bytes * 100.0, 100.0) : 0.0;
     
-    double byte_progress = total_bytes_.load() > 0 ? 
-        static_cast<double>(processed_bytes_.load()) / total_bytes_.load() * 100.0 : 0.0;
+    std::lock_guard<std::mutex> lock(display_mutex_);
     
     const int bar_width = 50;
-    int pos = static_cast<int>(file_progress / 100.0 * bar_width);
+    int pos = static_cast<int>(byte_progress / 100.0 * bar_width);
     
     clear_line();
     std::cout << "\r[";
@@ -67,9 +155,9 @@ void ProgressMonitor::print_progress_bar() const {
         else if (i == pos) std::cout << ">";
         else std::cout << " ";
     }
-    std::cout << "] " << std::fixed << std::setprecision(1) << file_progress << "% "
-              << "(" << completed_files_.load() << "/" << total_files_.load() << " files, "
-              << format_bytes(processed_bytes_.load()) << "/" << format_bytes(total_bytes_.load()) << ")";
+    std::cout << "] " << std::fixed << std::setprecision(1) << byte_progress << "% "
+              << "(" << done.completed << "/" << total_files << " files, "
+              << format_bytes(done.bytes) << "/" << format_bytes(total_bytes) << ")";
     std::cout.flush();
 }
 
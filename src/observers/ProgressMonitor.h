@@ -2,26 +2,62 @@
 
 #include "Observer.h"
 
+// Counts progress in per-thread slots, so notify() is a few uncontended
+// atomic adds, and redraws the progress bar from its own thread at a
+// fixed rate instead of once per event.
 class ProgressMonitor : public Observer<ProgressEvent> {
 private:
+    static constexpr size_t kSlots = 64;
+    
+    struct alignas(64) Counters {
+        std::atomic<size_t> bytes{0};
+        std::atomic<size_t> completed{0};
+        std::atomic<size_t> failed{0};
+    };
+    
+    struct Totals {
+        size_t bytes = 0;
+        size_t completed = 0;
+        size_t failed = 0;
+    };
+    
     std::atomic<size_t> total_files_;
-    std::atomic<size_t> completed_files_;
     std::atomic<size_t> total_bytes_;
-    std::atomic<size_t> processed_bytes_;
+    Counters counters_[kSlots];
     std::chrono::steady_clock::time_point start_time_;
     mutable std::mutex display_mutex_;
     bool verbose_;
     
+    std::thread render_thread_;
+    std::mutex render_mutex_;
+    std::condition_variable render_wakeup_;
+    bool rendering_;
+    
 public:
     explicit ProgressMonitor(bool verbose = false);
+    ~ProgressMonitor();
     
     void notify(const ProgressEvent& event) override;
     void set_totals(size_t files, size_t bytes);
+    
+    // Grows the totals as files are discovered during a streaming scan.
+    void add_totals(size_t files, size_t bytes);
+    
+    // Redraws the bar every interval until stop_rendering(), which draws it
+    // once more. Does nothing in verbose mode, where the log is the output.
+    void start_rendering(std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+    void stop_rendering();
+    
+    size_t completed_files() const;
+    size_t processed_bytes() const;
+    
     void print_summary() const;
     void print_progress_bar() const;
     
 private:
+    Totals totals() const;
+    void render_loop(std::chrono::milliseconds interval);
     std::string format_bytes(size_t bytes) const;
     std::string format_duration(double seconds) const;
     void clear_line() const;
-};
\ No newline at end of file
+};
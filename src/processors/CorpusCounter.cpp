@@ -0,0 +1,131 @@
+#include "CorpusCounter.h"
+#include "../core/ReportWriter.h"
+
+namespace {
+
+// Hands each worker thread its own first shard, so workers do not queue
+// up behind each other on shard 0.
+std::atomic<size_t> next_first_shard{0};
+
+}
+
+CorpusCounter::CorpusCounter() : files_(0), total_words_(0) {}
+
+// WordCounter places words by the low bits of the same hash, so the
+// shards take the high ones.
+size_t CorpusCounter::shard_of(uint64_t hash) {
+    return static_cast<size_t>(hash >> (64 - kShardBits));
+}
+
+void CorpusCounter::add(const WordCounter& words) {
+    ++files_;
+    if (words.empty()) {
+        return;
+    }
+    
+    // Counting-sort the file's words by shard so each shard is locked at
+    // most once per file. The buffers are reused by the next file on this
+    // thread.
+    thread_local std::vector<Pending> pending;
+    thread_local std::vector<size_t> shard_end;
+    shard_end.assign(kShards + 1, 0);
+    
+    size_t file_words = 0;
+    words.for_each_hashed([&](uint64_t hash, std::string_view, size_t count) {
+        ++shard_end[shard_of(hash) + 1];
+        file_words += count;
+    });
+    for (size_t shard = 1; shard <= kShards; ++shard) {
+        shard_end[shard] += shard_end[shard - 1];
+    }
+    
+    pending.resize(words.size());
+    words.for_each_hashed([&](uint64_t hash, std::string_view word, size_t count) {
+        pending[shard_end[shard_of(hash)]++] = Pending{hash, word, count};
+    });
+    
+    // shard_end[s] now ends shard s; shard s starts where s - 1 ended.
+    thread_local size_t first = next_first_shard++ % kShards;
+    for (size_t i = 0; i < kShards; ++i) {
+        size_t shard = (first + i) % kShards;
+        size_t begin = shard == 0 ? 0 : shard_end[shard - 1];
+        size_t end = shard_end[shard];
+        if (begin == end) {
+            continue;
+        }
+        
+        std::lock_guard<std::mutex> lock(shards_[shard].mutex);
+        for (size_t j = begin; j < end; ++j) {
+            shards_[shard].words.add_hashed(pending[j].hash, pending[j].word, pending[j].count);
+        }
+    }
+    
+    total_words_ += file_words;
+}
+
+std::vector<CorpusCounter::Entry> CorpusCounter::top(size_t k) const {
+    std::vector<Entry> candidates;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [word, count] : shard.words.top(k)) {
+            candidates.push_back(Entry{std::string(word), count});
+        }
+    }
+    
+    auto better = [](const Entry& a, const Entry& b) {
+        return a.count != b.count ? a.count > b.count : a.word < b.word;
+    };
+    size_t kept = std::min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(), better);
+    candidates.resize(kept);
+    return candidates;
+}
+
+std::string CorpusCounter::format_report(size_t top_words) const {
+    std::vector<Entry> top_list = top(top_words);
+    std::string report;
+    report.reserve(256 + top_list.size() * 32);
+    
+    report += "Corpus Analysis Report\n";
+    report += "======================\n\n";
+    report += "Statistics:\n";
+    report += "  Files: ";
+    append_decimal(report, files());
+    report += "\n  Words: ";
+    append_decimal(report, total_words());
+    report += "\n  Distinct words: ";
+    append_decimal(report, distinct_words());
+    report += "\n\n";
+    
+    report += "Top ";
+    append_decimal(report, top_words);
+    report += " Most Frequent Words:\n";
+    for (size_t i = 0; i < top_list.size(); ++i) {
+        report += "  ";
+        append_decimal(report, i + 1);
+        report += ". ";
+        report += top_list[i].word;
+        report += " (";
+        append_decimal(report, top_list[i].count);
+        report += " times)\n";
+    }
+    
+    return report;
+}
+
+size_t CorpusCounter::files() const {
+    return files_.load();
+}
+
+size_t CorpusCounter::total_words() const {
+    return total_words_.load();
+}
+
+size_t CorpusCounter::distinct_words() const {
+    size_t distinct = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        distinct += shard.words.size();
+    }
+    return distinct;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../../include/common.h"
+#include "WordCounter.h"
+
+// Word frequencies across every file of a run. Each file's table is added
+// by the worker that analyzed it, straight into kShards independently
+// locked WordCounters picked by the top bits of the word's hash, so
+// workers only wait for each other when they touch the same shard at the
+// same moment and nothing is left to merge once the last file is done.
+// A shard holds a disjoint set of words, so top() only has to combine the
+// shards' own top lists.
+class CorpusCounter {
+public:
+    struct Entry {
+        std::string word;
+        size_t count;
+    };
+    
+    CorpusCounter();
+    
+    CorpusCounter(const CorpusCounter&) = delete;
+    CorpusCounter& operator=(const CorpusCounter&) = delete;
+    
+    // Adds one file's word counts. Safe to call from any number of threads.
+    void add(const WordCounter& words);
+    
+    // The k most frequent words, most frequent first, ties in word order,
+    // like WordCounter::top().
+    std::vector<Entry> top(size_t k) const;
+    
+    // Text report in the style of the per-file ones: totals and the
+    // top_words most frequent words.
+    std::string format_report(size_t top_words) const;
+    
+    size_t files() const;
+    size_t total_words() const;
+    size_t distinct_words() const;
+    
+private:
+    // Sharded so concurrent adds rarely share a lock.
+    struct Shard {
+        mutable std::mutex mutex;
+        WordCounter words;
+    };
+    
+    struct Pending {
+        uint64_t hash;
+        std::string_view word;
+        size_t count;
+    };
+    
+    static constexpr unsigned kShardBits = 6;
+    static constexpr size_t kShards = size_t(1) << kShardBits;
+    
+    Shard shards_[kShards];
+    std::atomic<size_t> files_;
+    std::atomic<size_t> total_words_;
+    
+    static size_t shard_of(uint64_t hash);
+};
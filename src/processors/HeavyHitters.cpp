@@ -0,0 +1,269 @@
+#include "HeavyHitters.h"
+#include "WordCounter.h"
+
+namespace {
+
+// Rough per-counter footprint: the counter, its heap slot, two index
+// slots and a short word's heap buffer.
+constexpr size_t kBytesPerCounter = 96;
+
+}
+
+HeavyHitters::HeavyHitters(size_t capacity) : capacity_(0), total_(0) {
+    reset(capacity);
+}
+
+size_t HeavyHitters::capacity_for_memory(size_t bytes) {
+    return bytes == 0 ? 0 : std::max<size_t>(1, bytes / kBytesPerCounter);
+}
+
+bool HeavyHitters::enabled() const {
+    return capacity_ > 0;
+}
+
+void HeavyHitters::reset(size_t capacity) {
+    capacity_ = capacity;
+    counters_.clear();
+    heap_.clear();
+    counters_.reserve(capacity);
+    heap_.reserve(capacity);
+    
+    size_t slots = 2;
+    while (slots < capacity * 2) {
+        slots <<= 1;
+    }
+    index_.assign(capacity > 0 ? slots : 0, kEmpty);
+    total_ = 0;
+}
+
+void HeavyHitters::clear() {
+    reset(capacity_);
+}
+
+void HeavyHitters::add(std::string_view word) {
+    if (capacity_ == 0) {
+        return;
+    }
+    
+    scratch_.assign(word);
+    for (char& c : scratch_) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c + ('a' - 'A'));
+        }
+    }
+    uint64_t hash = WordCounter::hash_folded(scratch_);
+    ++total_;
+    
+    int32_t found = find(hash, scratch_);
+    if (found != kEmpty) {
+        Counter& counter = counters_[found];
+        ++counter.count;
+        sift_down(counter.heap_position);
+        return;
+    }
+    
+    if (counters_.size() < capacity_) {
+        uint32_t id = static_cast<uint32_t>(counters_.size());
+        counters_.push_back(Counter{scratch_, hash, 1, 0, heap_.size()});
+        heap_.push_back(id);
+        index_insert(id);
+        sift_up(heap_.size() - 1);
+        return;
+    }
+    
+    uint32_t victim = heap_.front();
+    index_erase(victim);
+    
+    Counter& counter = counters_[victim];
+    counter.word.assign(scratch_);
+    counter.hash = hash;
+    counter.error = counter.count;
+    ++counter.count;
+    
+    index_insert(victim);
+    sift_down(0);
+}
+
+void HeavyHitters::merge(const HeavyHitters& other) {
+    if (!other.enabled() || other.total_ == 0) {
+        return;
+    }
+    if (!enabled()) {
+        reset(other.capacity_);
+    }
+    
+    // A word missing from a full summary occurred at most its minimum
+    // count times there, so that minimum is added as count and error.
+    size_t own_floor = error_bound();
+    size_t other_floor = other.error_bound();
+    
+    std::vector<Counter> combined;
+    combined.reserve(counters_.size() + other.counters_.size());
+    
+    for (const Counter& counter : counters_) {
+        Counter merged = counter;
+        int32_t match = other.find(counter.hash, counter.word);
+        if (match != kEmpty) {
+            merged.count += other.counters_[match].count;
+            merged.error += other.counters_[match].error;
+        } else {
+            merged.count += other_floor;
+            merged.error += other_floor;
+        }
+        combined.push_back(std::move(merged));
+    }
+    
+    for (const Counter& counter : other.counters_) {
+        if (find(counter.hash, counter.word) == kEmpty) {
+            Counter merged = counter;
+            merged.count += own_floor;
+            merged.error += own_floor;
+            combined.push_back(std::move(merged));
+        }
+    }
+    
+    size_t total = total_ + other.total_;
+    rebuild(combined);
+    total_ = total;
+}
+
+std::vector<HeavyHitters::Entry> HeavyHitters::top(size_t k) const {
+    std::vector<const Counter*> ranked;
+    ranked.reserve(counters_.size());
+    for (const Counter& counter : counters_) {
+        ranked.push_back(&counter);
+    }
+    
+    k = std::min(k, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + k, ranked.end(),
+        [](const Counter* a, const Counter* b) {
+            return a->count != b->count ? a->count > b->count : a->word < b->word;
+        });
+    
+    std::vector<Entry> result;
+    result.reserve(k);
+    for (size_t i = 0; i < k; ++i) {
+        result.push_back(Entry{ranked[i]->word, ranked[i]->count, ranked[i]->error});
+    }
+    return result;
+}
+
+size_t HeavyHitters::capacity() const {
+    return capacity_;
+}
+
+size_t HeavyHitters::size() const {
+    return counters_.size();
+}
+
+size_t HeavyHitters::total() const {
+    return total_;
+}
+
+size_t HeavyHitters::error_bound() const {
+    if (capacity_ == 0 || counters_.size() < capacity_) {
+        return 0;
+    }
+    return counters_[heap_.front()].count;
+}
+
+int32_t HeavyHitters::find(uint64_t hash, std::string_view word) const {
+    if (index_.empty()) {
+        return kEmpty;
+    }
+    
+    size_t mask = index_.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        int32_t id = index_[slot];
+        if (id == kEmpty) {
+            return kEmpty;
+        }
+        if (counters_[id].hash == hash && counters_[id].word == word) {
+            return id;
+        }
+    }
+}
+
+void HeavyHitters::index_insert(uint32_t counter) {
+    size_t mask = index_.size() - 1;
+    size_t slot = counters_[counter].hash & mask;
+    while (index_[slot] != kEmpty) {
+        slot = (slot + 1) & mask;
+    }
+    index_[slot] = static_cast<int32_t>(counter);
+}
+
+// Backward-shift deletion keeps every probe chain intact without
+// tombstones.
+void HeavyHitters::index_erase(uint32_t counter) {
+    size_t mask = index_.size() - 1;
+    size_t slot = counters_[counter].hash & mask;
+    while (index_[slot] != static_cast<int32_t>(counter)) {
+        slot = (slot + 1) & mask;
+    }
+    
+    index_[slot] = kEmpty;
+    for (size_t next = (slot + 1) & mask; index_[next] != kEmpty; next = (next + 1) & mask) {
+        size_t home = counters_[index_[next]].hash & mask;
+        bool movable = (next > slot) ? (home <= slot || home > next)
+                                     : (home <= slot && home > next);
+        if (movable) {
+            index_[slot] = index_[next];
+            index_[next] = kEmpty;
+            slot = next;
+        }
+    }
+}
+
+void HeavyHitters::heap_swap(size_t a, size_t b) {
+    std::swap(heap_[a], heap_[b]);
+    counters_[heap_[a]].heap_position = a;
+    counters_[heap_[b]].heap_position = b;
+}
+
+void HeavyHitters::sift_up(size_t position) {
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (counters_[heap_[parent]].count <= counters_[heap_[position]].count) {
+            break;
+        }
+        heap_swap(parent, position);
+        position = parent;
+    }
+}
+
+void HeavyHitters::sift_down(size_t position) {
+    while (true) {
+        size_t smallest = position;
+        size_t left = position * 2 + 1;
+        size_t right = left + 1;
+        if (left < heap_.size() && counters_[heap_[left]].count < counters_[heap_[smallest]].count) {
+            smallest = left;
+        }
+        if (right < heap_.size() && counters_[heap_[right]].count < counters_[heap_[smallest]].count) {
+            smallest = right;
+        }
+        if (smallest == position) {
+            return;
+        }
+        heap_swap(position, smallest);
+        position = smallest;
+    }
+}
+
+void HeavyHitters::rebuild(std::vector<Counter>& counters) {
+    size_t keep = std::min(capacity_, counters.size());
+    std::partial_sort(counters.begin(), counters.begin() + keep, counters.end(),
+        [](const Counter& a, const Counter& b) { return a.count > b.count; });
+    counters.resize(keep);
+    
+    reset(capacity_);
+    for (Counter& counter : counters) {
+        uint32_t id = static_cast<uint32_t>(counters_.size());
+        counter.heap_position = heap_.size();
+        counters_.push_back(std::move(counter));
+        heap_.push_back(id);
+        index_insert(id);
+        sift_up(heap_.size() - 1);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../../include/common.h"
+
+// Bounded-memory approximate word frequencies (Space-Saving). At most
+// capacity() words are tracked; an unseen word replaces the current
+// minimum and inherits its count as error. Every reported count is at
+// least the true count and exceeds it by at most that entry's error,
+// which is itself at most error_bound() <= total() / capacity().
+class HeavyHitters {
+public:
+    struct Entry {
+        std::string word;
+        size_t count;
+        size_t error;
+    };
+    
+    explicit HeavyHitters(size_t capacity = 0);
+    
+    // Number of counters that fit in the given memory budget.
+    static size_t capacity_for_memory(size_t bytes);
+    
+    bool enabled() const;
+    void reset(size_t capacity);
+    void clear();
+    
+    // Counts word case-insensitively (ASCII), like WordCounter.
+    void add(std::string_view word);
+    
+    // Combines two summaries so the result keeps the same guarantees for
+    // the concatenated input.
+    void merge(const HeavyHitters& other);
+    
+    std::vector<Entry> top(size_t k) const;
+    
+    size_t capacity() const;
+    size_t size() const;
+    size_t total() const;
+    size_t error_bound() const;
+    
+private:
+    struct Counter {
+        std::string word;
+        uint64_t hash;
+        size_t count;
+        size_t error;
+        size_t heap_position;
+    };
+    
+    static constexpr int32_t kEmpty = -1;
+    
+    std::vector<Counter> counters_;
+    std::vector<uint32_t> heap_;
+    std::vector<int32_t> index_;
+    size_t capacity_;
+    size_t total_;
+    std::string scratch_;
+    
+    int32_t find(uint64_t hash, std::string_view word) const;
+    void index_insert(uint32_t counter);
+    void index_erase(uint32_t counter);
+    void heap_swap(size_t a, size_t b);
+    void sift_up(size_t position);
+    void sift_down(size_t position);
+    void rebuild(std::vector<Counter>& counters);
+};
@@ -0,0 +1,184 @@
+#include "TextKernel.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEXT_KERNEL_X86 1
+#endif
+
+namespace {
+
+BlockClass classify_scalar(const char* data, size_t length) {
+    BlockClass result;
+    for (size_t i = 0; i < length; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        if (TextKernel::is_word_char(data[i])) {
+            result.word_chars |= bit;
+        } else if (data[i] == '\n') {
+            result.newlines |= bit;
+        }
+    }
+    return result;
+}
+
+uint64_t length_mask(size_t length) {
+    return length >= 64 ? ~uint64_t(0) : (uint64_t(1) << length) - 1;
+}
+
+#ifdef TEXT_KERNEL_X86
+
+// Short blocks are copied into a zero-padded buffer; NUL is neither a word
+// character nor a newline, and the padding bits are masked off anyway.
+const char* padded_block(const char* data, size_t length, char* scratch) {
+    if (length >= TextKernel::kBlockSize) {
+        return data;
+    }
+    std::memset(scratch, 0, TextKernel::kBlockSize);
+    std::memcpy(scratch, data, length);
+    return scratch;
+}
+
+// Bytes >= 0x80 are negative under the signed compares below, so they fall
+// outside every range and never count as word characters.
+__attribute__((target("sse2")))
+uint32_t word_mask_sse2(__m128i bytes, uint32_t& newline_mask) {
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), bytes));
+    __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), folded));
+    __m128i extra = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')),
+                                 _mm_cmpeq_epi8(bytes, _mm_set1_epi8('-')));
+    newline_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(digit, alpha), extra)));
+}
+
+__attribute__((target("sse2")))
+BlockClass classify_sse2(const char* data, size_t length) {
+    char scratch[TextKernel::kBlockSize];
+    const char* block = padded_block(data, length, scratch);
+    
+    BlockClass result;
+    for (size_t lane = 0; lane < 4; ++lane) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + lane * 16));
+        uint32_t newlines;
+        uint32_t words = word_mask_sse2(bytes, newlines);
+        result.word_chars |= uint64_t(words) << (lane * 16);
+        result.newlines |= uint64_t(newlines) << (lane * 16);
+    }
+    
+    uint64_t valid = length_mask(length);
+    result.word_chars &= valid;
+    result.newlines &= valid;
+    return result;
+}
+
+__attribute__((target("avx2")))
+BlockClass classify_avx2(const char* data, size_t length) {
+    char scratch[TextKernel::kBlockSize];
+    const char* block = padded_block(data, length, scratch);
+    
+    BlockClass result;
+    for (size_t lane = 0; lane < 2; ++lane) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + lane * 32));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('0' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), bytes));
+        __m256i folded = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+        __m256i extra = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')),
+                                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('-')));
+        __m256i words = _mm256_or_si256(_mm256_or_si256(digit, alpha), extra);
+        __m256i newlines = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'));
+        
+        result.word_chars |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(words))) << (lane * 32);
+        result.newlines |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(newlines))) << (lane * 32);
+    }
+    
+    uint64_t valid = length_mask(length);
+    result.word_chars &= valid;
+    result.newlines &= valid;
+    return result;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+BlockClass classify_avx512(const char* data, size_t length) {
+    uint64_t valid = length_mask(length);
+    __m512i bytes = _mm512_maskz_loadu_epi8(valid, data);
+    
+    __mmask64 digit = _mm512_cmpgt_epi8_mask(bytes, _mm512_set1_epi8('0' - 1)) &
+                      _mm512_cmpgt_epi8_mask(_mm512_set1_epi8('9' + 1), bytes);
+    __m512i folded = _mm512_or_si512(bytes, _mm512_set1_epi8(0x20));
+    __mmask64 alpha = _mm512_cmpgt_epi8_mask(folded, _mm512_set1_epi8('a' - 1)) &
+                      _mm512_cmpgt_epi8_mask(_mm512_set1_epi8('z' + 1), folded);
+    __mmask64 extra = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('_')) |
+                      _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('-'));
+    
+    BlockClass result;
+    result.word_chars = (digit | alpha | extra) & valid;
+    result.newlines = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\n')) & valid;
+    return result;
+}
+
+#endif
+
+}
+
+TextKernel::TextKernel(ClassifyFn classify, KernelLevel level) : classify_(classify), level_(level) {}
+
+bool TextKernel::supported(KernelLevel level) {
+#ifdef TEXT_KERNEL_X86
+    switch (level) {
+        case KernelLevel::SCALAR: return true;
+        case KernelLevel::SSE2: return __builtin_cpu_supports("sse2");
+        case KernelLevel::AVX2: return __builtin_cpu_supports("avx2");
+        case KernelLevel::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#else
+    return level == KernelLevel::SCALAR;
+#endif
+}
+
+TextKernel TextKernel::for_level(KernelLevel level) {
+    if (!supported(level)) {
+        throw std::runtime_error("Text kernel level not supported on this CPU");
+    }
+    
+#ifdef TEXT_KERNEL_X86
+    switch (level) {
+        case KernelLevel::SSE2: return TextKernel(classify_sse2, level);
+        case KernelLevel::AVX2: return TextKernel(classify_avx2, level);
+        case KernelLevel::AVX512: return TextKernel(classify_avx512, level);
+        case KernelLevel::SCALAR: break;
+    }
+#endif
+    return TextKernel(classify_scalar, KernelLevel::SCALAR);
+}
+
+const TextKernel& TextKernel::best() {
+    static const TextKernel kernel = [] {
+        for (KernelLevel level : {KernelLevel::AVX512, KernelLevel::AVX2, KernelLevel::SSE2}) {
+            if (supported(level)) {
+                return for_level(level);
+            }
+        }
+        return for_level(KernelLevel::SCALAR);
+    }();
+    return kernel;
+}
+
+KernelLevel TextKernel::level() const {
+    return level_;
+}
+
+const char* TextKernel::name() const {
+    switch (level_) {
+        case KernelLevel::SCALAR: return "scalar";
+        case KernelLevel::SSE2: return "sse2";
+        case KernelLevel::AVX2: return "avx2";
+        case KernelLevel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
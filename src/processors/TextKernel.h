@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../../include/common.h"
+
+// Character classes for one block of up to 64 input bytes; bit i describes
+// data[i]. Bits at and beyond the block length are always clear.
+struct BlockClass {
+    uint64_t word_chars = 0;
+    uint64_t newlines = 0;
+};
+
+enum class KernelLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Classifies text 64 bytes at a time. Word characters are ASCII letters,
+// digits, '_' and '-'; every other byte, including all bytes >= 0x80,
+// separates words. The best implementation for the running CPU is picked
+// once at startup; all levels produce identical masks.
+class TextKernel {
+public:
+    static constexpr size_t kBlockSize = 64;
+    
+    using ClassifyFn = BlockClass (*)(const char* data, size_t length);
+    
+    static const TextKernel& best();
+    static bool supported(KernelLevel level);
+    static TextKernel for_level(KernelLevel level);
+    
+    static bool is_word_char(char c) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        unsigned char folded = byte | 0x20;
+        return (byte >= '0' && byte <= '9') || (folded >= 'a' && folded <= 'z') ||
+               byte == '_' || byte == '-';
+    }
+    
+    BlockClass classify(const char* data, size_t length) const {
+        return classify_(data, length);
+    }
+    
+    KernelLevel level() const;
+    const char* name() const;
+    
+private:
+    ClassifyFn classify_;
+    KernelLevel level_;
+    
+    TextKernel(ClassifyFn classify, KernelLevel level);
+};
@@ -1,61 +1,144 @@
 #include "TextProcessor.h"
 #include "../utils/Logger.h"
+#include <cerrno>
+#include <cstring>
 
 TextProcessor::TextProcessor(const std::string& output_dir, size_t chunk_size)
-    : FileProcessor(output_dir), chunk_size_(chunk_size) {}
+    : FileProcessor(output_dir), chunk_size_(chunk_size), range_pool_(nullptr),
+      split_threshold_(0), min_range_bytes_(1 << 20), kernel_(TextKernel::best()),
+      heavy_hitter_capacity_(0), corpus_(nullptr) {}
+
+void TextProcessor::set_text_kernel(KernelLevel level) {
+    kernel_ = TextKernel::for_level(level);
+}
+
+void TextProcessor::set_heavy_hitters_memory(size_t memory_bytes) {
+    heavy_hitter_capacity_ = HeavyHitters::capacity_for_memory(memory_bytes);
+}
+
+void TextProcessor::set_corpus_counter(CorpusCounter* counter) {
+    corpus_ = counter;
+}
+
+void TextProcessor::enable_range_splitting(ThreadPool* pool, size_t threshold, size_t min_range_bytes) {
+    range_pool_ = pool;
+    split_threshold_ = threshold;
+    min_range_bytes_ = std::max<size_t>(min_range_bytes, 1);
+}
 
 ProcessResult TextProcessor::process_impl(const std::string& filepath) {
     ProcessResult result;
     
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
+    InputFile input;
+    if (!open_input(filepath, input)) {
         result.message = "Cannot open file: " + filepath;
         return result;
     }
     
-    std::string content;
-    std::string line;
-    size_t processed_bytes = 0;
-    size_t total_bytes = fs::file_size(filepath);
+    size_t total_bytes = input.size();
+    
+    TextStats& stats = stats_;
+    reset_stats(stats);
     
-    while (std::getline(file, line)) {
-        content += line + "\n";
-        processed_bytes += line.length() + 1;
+    if (range_pool_ && split_threshold_ > 0 && total_bytes >= split_threshold_) {
+        if (!analyze_ranges(filepath, input, stats)) {
+            result.message = "Error reading file: " + filepath;
+            return result;
+        }
+        // XXH64 needs the bytes in order, so the ranges cannot feed it;
+        // one pass over the file, usually still in the page cache.
+        ContentHasher* hasher = content_hasher();
+        if (hasher && !input.read_range(0, total_bytes, 1 << 20, read_buffer_,
+                                        [hasher](std::string_view chunk) { hasher->update(chunk); })) {
+            result.message = "Error reading file: " + filepath;
+            return result;
+        }
+    } else {
+        ScanState state;
+        ProgressReporter progress = progress_reporter();
+        ContentHasher* hasher = content_hasher();
         
-        if (content.length() >= chunk_size_) {
-            std::string processed_chunk = process_chunk(content);
-            content.clear();
-            
-            notify_progress(filepath, processed_bytes, total_bytes, "processing");
+        bool read_ok = input.for_each_chunk(chunk_size_, read_buffer_, [&](std::string_view chunk) {
+            if (hasher) {
+                hasher->update(chunk);
+            }
+            analyze_chunk(chunk, stats, state);
+            progress.advance(chunk.size());
+        });
+        
+        if (!read_ok) {
+            result.message = "Error reading file: " + filepath + " (" + input.error() + ")";
+            return result;
         }
+        
+        finish_analysis(stats, state);
     }
     
-    if (!content.empty()) {
-        process_chunk(content);
-    }
-    
-    file.close();
+    return finish_file(filepath, stats);
+}
+
+ProcessResult TextProcessor::process_contents_impl(const std::string& filepath, std::string_view contents) {
+    TextStats& stats = stats_;
+    reset_stats(stats);
     
-    std::ifstream full_file(filepath);
-    std::string full_content((std::istreambuf_iterator<char>(full_file)),
-                            std::istreambuf_iterator<char>());
-    full_file.close();
+    ScanState state;
+    analyze_chunk(contents, stats, state);
+    finish_analysis(stats, state);
     
-    TextStats stats = analyze_text(full_content);
+    return finish_file(filepath, stats);
+}
+
+ProcessResult TextProcessor::finish_file(const std::string& filepath, const TextStats& stats) {
+    ProcessResult result;
+    std::vector<HeavyHitters::Entry> approximate;
+    std::vector<TopWord> top = top_words(stats, approximate);
+    if (corpus_ && !stats.heavy_hitters.enabled()) {
+        corpus_->add(stats.word_frequency);
+    }
+    std::string output_path;
+    if (consolidated_reports()) {
+        output_path = report_writer_->stream_path();
+        report_writer_->append(format_json_record(filepath, stats, top));
+    } else {
+        output_path = report_path(filepath);
+        if (!write_report(output_path, format_text_report(stats, top))) {
+            LOG_ERROR("Cannot create analysis report: {}", output_path);
+        }
+    }
     
-    std::string output_path = get_output_path(filepath, "_analysis");
-    write_analysis_report(output_path, stats);
+    // Words never contain whitespace, so "word count word count ..." is
+    // unambiguous.
+    size_t list_bytes = 0;
+    for (const TopWord& entry : top) {
+        list_bytes += entry.word.size() + 22;
+    }
+    std::string top_list;
+    top_list.reserve(list_bytes);
+    for (const TopWord& entry : top) {
+        if (!top_list.empty()) {
+            top_list += ' ';
+        }
+        top_list += entry.word;
+        top_list += ' ';
+        append_decimal(top_list, entry.count);
+    }
     
     result.success = true;
     result.message = "Text processing completed";
     result.metadata["lines"] = std::to_string(stats.lines);
     result.metadata["words"] = std::to_string(stats.words);
     result.metadata["characters"] = std::to_string(stats.characters);
+    result.metadata["paragraphs"] = std::to_string(stats.paragraphs);
+    result.metadata["top_words"] = std::move(top_list);
     result.metadata["output_file"] = output_path;
     
     return result;
 }
 
+std::string TextProcessor::report_path(const std::string& filepath) const {
+    return get_output_path(filepath, "_analysis");
+}
+
 bool TextProcessor::canProcess(const std::string& extension) const {
     static const std::unordered_set<std::string> supported_extensions = {
         ".txt", ".md", ".csv", ".log", ".json", ".xml", ".html", ".css", ".js"
@@ -67,115 +150,336 @@ std::string TextProcessor::getProcessorName() const {
     return "TextProcessor";
 }
 
-TextProcessor::TextStats TextProcessor::analyze_text(const std::string& content) {
+TextProcessor::TextStats TextProcessor::make_stats() const {
     TextStats stats;
+    stats.heavy_hitters.reset(heavy_hitter_capacity_);
+    return stats;
+}
+
+void TextProcessor::reset_stats(TextStats& stats) const {
+    stats.lines = 0;
+    stats.words = 0;
+    stats.characters = 0;
+    stats.paragraphs = 0;
+    stats.word_frequency.clear();
     
-    stats.characters = content.length();
+    if (stats.heavy_hitters.capacity() == heavy_hitter_capacity_) {
+        stats.heavy_hitters.clear();
+    } else {
+        stats.heavy_hitters.reset(heavy_hitter_capacity_);
+    }
+}
+
+TextProcessor::TextStats TextProcessor::analyze_text(std::string_view content) {
+    TextStats stats = make_stats();
+    ScanState state;
+    analyze_chunk(content, stats, state);
+    finish_analysis(stats, state);
+    return stats;
+}
+
+// Works on the kernel's 64-byte masks instead of single bytes: word
+// boundaries are the bits where the word mask changes, and lines are the
+// newline bits. A line counts toward a paragraph once it has any byte
+// besides the newline; an empty line closes the paragraph. Words never
+// span lines because '\n' is not a word character.
+void TextProcessor::analyze_chunk(std::string_view chunk, TextStats& stats, ScanState& state) {
+    stats.characters += chunk.size();
     
-    std::istringstream stream(content);
-    std::string line;
-    bool in_paragraph = false;
+    // A word carried over from the previous chunk continues at offset 0.
+    bool in_word = !state.current_word.empty();
+    size_t word_begin = 0;
     
-    while (std::getline(stream, line)) {
-        stats.lines++;
+    for (size_t offset = 0; offset < chunk.size(); offset += TextKernel::kBlockSize) {
+        size_t length = std::min(TextKernel::kBlockSize, chunk.size() - offset);
+        BlockClass block = kernel_.classify(chunk.data() + offset, length);
+        uint64_t valid = length == 64 ? ~uint64_t(0) : (uint64_t(1) << length) - 1;
         
-        if (line.empty()) {
-            if (in_paragraph) {
-                stats.paragraphs++;
-                in_paragraph = false;
+        uint64_t boundaries = (block.word_chars ^ ((block.word_chars << 1) | (in_word ? 1 : 0))) & valid;
+        while (boundaries) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctzll(boundaries));
+            boundaries &= boundaries - 1;
+            
+            if ((block.word_chars >> bit) & 1) {
+                word_begin = offset + bit;
+            } else if (!state.current_word.empty()) {
+                state.current_word.append(chunk.data(), offset + bit);
+                count_word(stats, state.current_word);
+                state.current_word.clear();
+            } else {
+                count_word(stats, chunk.substr(word_begin, offset + bit - word_begin));
             }
-        } else {
-            in_paragraph = true;
+        }
+        in_word = (block.word_chars >> (length - 1)) & 1;
+        
+        uint64_t content = ~block.newlines & valid;
+        uint64_t newlines = block.newlines;
+        unsigned line_start = 0;
+        stats.lines += static_cast<size_t>(__builtin_popcountll(newlines));
+        
+        while (newlines) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctzll(newlines));
+            newlines &= newlines - 1;
             
-            std::vector<std::string> words = tokenize(line);
-            stats.words += words.size();
+            uint64_t line_bits = content & ((uint64_t(1) << bit) - 1) & ~((uint64_t(1) << line_start) - 1);
+            if (line_bits) {
+                state.line_has_content = true;
+                state.in_paragraph = true;
+            }
             
-            for (const auto& word : words) {
-                std::string lower_word = to_lower(word);
-                stats.word_frequency[lower_word]++;
+            if (!state.line_has_content && state.in_paragraph) {
+                stats.paragraphs++;
+                state.in_paragraph = false;
             }
+            state.line_has_content = false;
+            line_start = bit + 1;
+        }
+        
+        if (line_start < 64 && (content >> line_start) != 0) {
+            state.line_has_content = true;
+            state.in_paragraph = true;
         }
     }
     
-    if (in_paragraph) {
-        stats.paragraphs++;
+    if (in_word) {
+        state.current_word.append(chunk.substr(word_begin));
     }
-    
-    return stats;
 }
 
-std::string TextProcessor::process_chunk(const std::string& chunk) {
-    std::string processed = chunk;
+// Ranges start at line boundaries, so no word or line spans two of them.
+// Each range is scanned as if no paragraph were open before it; the merge
+// then adds the paragraph that an open one would have closed at the
+// range's leading empty line, and carries the open state forward.
+bool TextProcessor::analyze_ranges(const std::string& filepath, const InputFile& input, TextStats& stats) {
+    size_t total_bytes = input.size();
+    size_t range_count = std::clamp<size_t>(total_bytes / min_range_bytes_, 2, range_pool_->size() * 4);
     
-    std::transform(processed.begin(), processed.end(), processed.begin(),
-                  [](char c) { return std::isspace(c) ? ' ' : c; });
+    std::vector<size_t> bounds = {0};
+    for (size_t i = 1; i < range_count; ++i) {
+        size_t bound = input.next_line_start(total_bytes / range_count * i);
+        if (bound > bounds.back() && bound < total_bytes) {
+            bounds.push_back(bound);
+        }
+    }
+    bounds.push_back(total_bytes);
     
-    processed.erase(std::unique(processed.begin(), processed.end(),
-                               [](char a, char b) { return a == ' ' && b == ' '; }),
-                   processed.end());
+    std::vector<std::future<RangeStats>> futures;
     
-    return processed;
-}
-
-std::vector<std::string> TextProcessor::tokenize(const std::string& text) {
-    std::vector<std::string> tokens;
-    std::string current_word;
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+        size_t begin = bounds[i];
+        size_t length = bounds[i + 1] - begin;
+        
+        futures.push_back(range_pool_->enqueue([this, &input, begin, length]() {
+            RangeStats range;
+            range.stats = make_stats();
+            ScanState state;
+            ProgressReporter progress = progress_reporter();
+            std::vector<char> buffer;
+            bool first_chunk = true;
+            
+            bool read_ok = input.read_range(begin, length, chunk_size_, buffer, [&](std::string_view chunk) {
+                if (first_chunk) {
+                    range.starts_with_empty_line = chunk.front() == '\n';
+                    first_chunk = false;
+                }
+                analyze_chunk(chunk, range.stats, state);
+                progress.advance(chunk.size());
+            });
+            
+            if (!read_ok) {
+                throw std::runtime_error(std::strerror(errno));
+            }
+            
+            finish_line(range.stats, state);
+            range.ends_in_paragraph = state.in_paragraph;
+            return range;
+        }));
+    }
     
-    for (char c : text) {
-        if (is_word_char(c)) {
-            current_word += c;
-        } else {
-            if (!current_word.empty()) {
-                tokens.push_back(current_word);
-                current_word.clear();
+    // Every range references this frame, so all of them must finish before
+    // any result (or exception) is taken.
+    for (auto& future : futures) {
+        range_pool_->help_until_ready(future);
+    }
+    
+    bool ok = true;
+    bool in_paragraph = false;
+    for (auto& future : futures) {
+        try {
+            RangeStats range = future.get();
+            
+            if (in_paragraph && range.starts_with_empty_line) {
+                stats.paragraphs++;
             }
+            merge_stats(stats, range.stats);
+            in_paragraph = range.ends_in_paragraph;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Range analysis failed for {}: {}", filepath, e.what());
+            ok = false;
         }
     }
     
-    if (!current_word.empty()) {
-        tokens.push_back(current_word);
+    if (in_paragraph) {
+        stats.paragraphs++;
     }
     
-    return tokens;
+    return ok;
 }
 
-std::string TextProcessor::to_lower(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-    return result;
+void TextProcessor::merge_stats(TextStats& into, const TextStats& from) {
+    into.lines += from.lines;
+    into.words += from.words;
+    into.characters += from.characters;
+    into.paragraphs += from.paragraphs;
+    
+    into.word_frequency.merge(from.word_frequency);
+    into.heavy_hitters.merge(from.heavy_hitters);
+}
+
+void TextProcessor::finish_line(TextStats& stats, ScanState& state) {
+    if (!state.current_word.empty()) {
+        count_word(stats, state.current_word);
+        state.current_word.clear();
+    }
+    
+    if (state.line_has_content) {
+        stats.lines++;
+        state.line_has_content = false;
+    }
 }
 
-bool TextProcessor::is_word_char(char c) {
-    return std::isalnum(c) || c == '_' || c == '-';
+void TextProcessor::finish_analysis(TextStats& stats, ScanState& state) {
+    finish_line(stats, state);
+    
+    if (state.in_paragraph) {
+        stats.paragraphs++;
+        state.in_paragraph = false;
+    }
 }
 
-void TextProcessor::write_analysis_report(const std::string& output_path, const TextStats& stats) {
-    std::ofstream report(output_path);
-    if (!report.is_open()) {
-        Logger::getInstance().error("Cannot create analysis report: " + output_path);
-        return;
+void TextProcessor::count_word(TextStats& stats, std::string_view word) {
+    stats.words++;
+    if (stats.heavy_hitters.enabled()) {
+        stats.heavy_hitters.add(word);
+    } else {
+        stats.word_frequency.add(word);
     }
+}
+
+std::vector<TextProcessor::TopWord> TextProcessor::top_words(const TextStats& stats,
+                                                             std::vector<HeavyHitters::Entry>& storage) const {
+    std::vector<TopWord> top;
+    top.reserve(kTopWords);
     
-    report << "Text Analysis Report\n";
-    report << "===================\n\n";
-    report << "Statistics:\n";
-    report << "  Lines: " << stats.lines << "\n";
-    report << "  Words: " << stats.words << "\n";
-    report << "  Characters: " << stats.characters << "\n";
-    report << "  Paragraphs: " << stats.paragraphs << "\n\n";
+    if (stats.heavy_hitters.enabled()) {
+        storage = stats.heavy_hitters.top(kTopWords);
+        for (const HeavyHitters::Entry& entry : storage) {
+            top.push_back(TopWord{entry.word, entry.count, entry.error});
+        }
+    } else {
+        for (const auto& [word, count] : stats.word_frequency.top(kTopWords)) {
+            top.push_back(TopWord{word, count, 0});
+        }
+    }
+    return top;
+}
+
+std::string TextProcessor::format_text_report(const TextStats& stats, const std::vector<TopWord>& top) const {
+    std::string report;
+    report.reserve(512);
     
-    report << "Top 10 Most Frequent Words:\n";
+    report += "Text Analysis Report\n";
+    report += "===================\n\n";
+    report += "Statistics:\n";
+    report += "  Lines: ";
+    append_decimal(report, stats.lines);
+    report += "\n  Words: ";
+    append_decimal(report, stats.words);
+    report += "\n  Characters: ";
+    append_decimal(report, stats.characters);
+    report += "\n  Paragraphs: ";
+    append_decimal(report, stats.paragraphs);
+    report += "\n\n";
     
-    std::vector<std::pair<std::string, size_t>> word_pairs(
-        stats.word_frequency.begin(), stats.word_frequency.end());
+    if (stats.heavy_hitters.enabled()) {
+        const HeavyHitters& summary = stats.heavy_hitters;
+        report += "Top 10 Most Frequent Words (approximate, ";
+        append_decimal(report, summary.capacity());
+        report += " counters):\n";
+        
+        for (size_t i = 0; i < top.size(); ++i) {
+            report += "  ";
+            append_decimal(report, i + 1);
+            report += ". ";
+            report += top[i].word;
+            report += " (";
+            append_decimal(report, top[i].count);
+            report += " times, overcount <= ";
+            append_decimal(report, top[i].error);
+            report += ")\n";
+        }
+        
+        report += "  Counts exceed true counts by at most ";
+        append_decimal(report, summary.error_bound());
+        report += " (";
+        append_decimal(report, summary.total());
+        report += " words / ";
+        append_decimal(report, summary.capacity());
+        report += " counters)\n";
+    } else {
+        report += "Top 10 Most Frequent Words:\n";
+        
+        for (size_t i = 0; i < top.size(); ++i) {
+            report += "  ";
+            append_decimal(report, i + 1);
+            report += ". ";
+            report += top[i].word;
+            report += " (";
+            append_decimal(report, top[i].count);
+            report += " times)\n";
+        }
+    }
     
-    std::sort(word_pairs.begin(), word_pairs.end(),
-             [](const auto& a, const auto& b) { return a.second > b.second; });
+    return report;
+}
+
+// One line per file for the consolidated stream. Approximate counts carry
+// their overcount and the summary's error bound.
+std::string TextProcessor::format_json_record(const std::string& filepath, const TextStats& stats,
+                                              const std::vector<TopWord>& top) const {
+    std::string record;
+    record.reserve(384 + filepath.size());
+    
+    record += "{\"file\":";
+    append_json_string(record, filepath);
+    record += ",\"lines\":";
+    append_decimal(record, stats.lines);
+    record += ",\"words\":";
+    append_decimal(record, stats.words);
+    record += ",\"characters\":";
+    append_decimal(record, stats.characters);
+    record += ",\"paragraphs\":";
+    append_decimal(record, stats.paragraphs);
+    record += ",\"top_words\":[";
     
-    for (size_t i = 0; i < std::min(size_t(10), word_pairs.size()); ++i) {
-        report << "  " << (i + 1) << ". " << word_pairs[i].first 
-               << " (" << word_pairs[i].second << " times)\n";
+    bool approximate = stats.heavy_hitters.enabled();
+    for (size_t i = 0; i < top.size(); ++i) {
+        record += i ? ",{\"word\":" : "{\"word\":";
+        append_json_string(record, top[i].word);
+        record += ",\"count\":";
+        append_decimal(record, top[i].count);
+        if (approximate) {
+            record += ",\"overcount\":";
+            append_decimal(record, top[i].error);
+        }
+        record += '}';
+    }
+    record += ']';
+    if (approximate) {
+        record += ",\"error_bound\":";
+        append_decimal(record, stats.heavy_hitters.error_bound());
     }
     
-    report.close();
-}
\ No newline at end of file
+    record += "}\n";
+    return record;
+}
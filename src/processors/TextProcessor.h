@@ -1,15 +1,51 @@
 #pragma once
 
 #include "../core/FileProcessor.h"
+#include "../core/ThreadPool.h"
+#include "TextKernel.h"
+#include "WordCounter.h"
+#include "HeavyHitters.h"
+#include "CorpusCounter.h"
 
 class TextProcessor : public FileProcessor<TextProcessor> {
+public:
+    // Words listed per file in reports and results.
+    static constexpr size_t kTopWords = 10;
+    
 private:
     size_t chunk_size_;
+    ThreadPool* range_pool_;
+    size_t split_threshold_;
+    size_t min_range_bytes_;
+    TextKernel kernel_;
+    size_t heavy_hitter_capacity_;
+    CorpusCounter* corpus_;
     
 public:
     explicit TextProcessor(const std::string& output_dir = "./output", size_t chunk_size = 1024);
     
+    // Files of at least threshold bytes are split at line boundaries into
+    // ranges of at least min_range_bytes, analyzed as separate tasks on
+    // pool and merged. A threshold of 0 disables splitting.
+    void enable_range_splitting(ThreadPool* pool, size_t threshold, size_t min_range_bytes = 1 << 20);
+    
+    // Overrides the runtime-selected classification kernel; throws if the
+    // CPU lacks the instruction set.
+    void set_text_kernel(KernelLevel level);
+    
+    // Replaces exact word frequencies with a Space-Saving summary of at
+    // most memory_bytes; the report then lists approximate counts with
+    // their error bounds. 0 restores exact counting.
+    void set_heavy_hitters_memory(size_t memory_bytes);
+    
+    // Adds every analyzed file's exact word counts to counter, which may
+    // be shared by all processors of a run. Files summarized by heavy
+    // hitters are not added. nullptr stops adding.
+    void set_corpus_counter(CorpusCounter* counter);
+    
     ProcessResult process_impl(const std::string& filepath);
+    ProcessResult process_contents_impl(const std::string& filepath, std::string_view contents);
+    std::string report_path(const std::string& filepath) const;
     bool canProcess(const std::string& extension) const override;
     std::string getProcessorName() const override;
     
@@ -19,13 +55,50 @@ private:
         size_t words = 0;
         size_t characters = 0;
         size_t paragraphs = 0;
-        std::unordered_map<std::string, size_t> word_frequency;
+        WordCounter word_frequency;
+        HeavyHitters heavy_hitters;
+    };
+    
+    // Carries a line/word/paragraph in progress across chunk boundaries so
+    // a file can be analyzed from fixed-size buffers in one pass.
+    struct ScanState {
+        bool line_has_content = false;
+        bool in_paragraph = false;
+        std::string current_word;
+    };
+    
+    struct RangeStats {
+        TextStats stats;
+        bool starts_with_empty_line = false;
+        bool ends_in_paragraph = false;
+    };
+    
+    // Reused across files so a long-lived processor keeps its buffer and
+    // word table capacity instead of reallocating them per file.
+    std::vector<char> read_buffer_;
+    TextStats stats_;
+    
+    TextStats make_stats() const;
+    void reset_stats(TextStats& stats) const;
+    TextStats analyze_text(std::string_view content);
+    bool analyze_ranges(const std::string& filepath, const InputFile& input, TextStats& stats);
+    void analyze_chunk(std::string_view chunk, TextStats& stats, ScanState& state);
+    void finish_line(TextStats& stats, ScanState& state);
+    void finish_analysis(TextStats& stats, ScanState& state);
+    void merge_stats(TextStats& into, const TextStats& from);
+    void count_word(TextStats& stats, std::string_view word);
+    ProcessResult finish_file(const std::string& filepath, const TextStats& stats);
+    // Most frequent words first; error is the overcount bound of an
+    // approximate count and 0 for exact ones. Approximate words live in
+    // storage.
+    struct TopWord {
+        std::string_view word;
+        size_t count;
+        size_t error;
     };
     
-    TextStats analyze_text(const std::string& content);
-    std::string process_chunk(const std::string& chunk);
-    std::vector<std::string> tokenize(const std::string& text);
-    std::string to_lower(const std::string& str);
-    bool is_word_char(char c);
-    void write_analysis_report(const std::string& output_path, const TextStats& stats);
+    std::vector<TopWord> top_words(const TextStats& stats, std::vector<HeavyHitters::Entry>& storage) const;
+    std::string format_text_report(const TextStats& stats, const std::vector<TopWord>& top) const;
+    std::string format_json_record(const std::string& filepath, const TextStats& stats,
+                                   const std::vector<TopWord>& top) const;
 };
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "WordCounter.h"
+#include <cstring>
+
+namespace {
+
+char fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// Lower-cases the ASCII capitals in eight bytes at once. A byte is a
+// capital when adding 0x3F sets its top bit (>= 'A') and adding 0x25 does
+// not (<= 'Z'); the mask is then shifted down onto the 0x20 bit.
+uint64_t fold8(uint64_t bytes) {
+    const uint64_t high_bits = 0x8080808080808080ULL;
+    uint64_t low7 = bytes & ~high_bits;
+    uint64_t at_least_a = low7 + 0x3F3F3F3F3F3F3F3FULL;
+    uint64_t above_z = low7 + 0x2525252525252525ULL;
+    uint64_t capitals = at_least_a & ~above_z & ~bytes & high_bits;
+    return bytes | (capitals >> 2);
+}
+
+uint64_t mix(uint64_t hash, uint64_t bytes) {
+    hash = (hash ^ bytes) * 0xBF58476D1CE4E5B9ULL;
+    return hash ^ (hash >> 31);
+}
+
+bool equals_folded(const char* stored, std::string_view word) {
+    for (size_t i = 0; i < word.size(); ++i) {
+        if (stored[i] != fold(word[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+WordCounter::WordCounter() : slots_(kInitialSlots), size_(0), arena_block_(0), arena_used_(0) {}
+
+uint64_t WordCounter::hash_folded(std::string_view word) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ word.size();
+    size_t i = 0;
+    
+    for (; i + 8 <= word.size(); i += 8) {
+        uint64_t bytes;
+        std::memcpy(&bytes, word.data() + i, 8);
+        hash = mix(hash, fold8(bytes));
+    }
+    
+    if (i < word.size()) {
+        uint64_t bytes = 0;
+        std::memcpy(&bytes, word.data() + i, word.size() - i);
+        hash = mix(hash, fold8(bytes));
+    }
+    
+    hash ^= hash >> 29;
+    hash *= 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 32);
+}
+
+void WordCounter::add(std::string_view word, size_t count) {
+    add_hashed(hash_folded(word), word, count);
+}
+
+void WordCounter::add_hashed(uint64_t hash, std::string_view word, size_t count) {
+    size_t mask = slots_.size() - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+        Slot& slot = slots_[index];
+        if (!slot.data) {
+            slot.hash = hash;
+            slot.data = intern(word);
+            slot.length = static_cast<uint32_t>(word.size());
+            slot.count = count;
+            used_.push_back(static_cast<uint32_t>(index));
+            if (++size_ * 10 >= slots_.size() * 7) {
+                grow();
+            }
+            return;
+        }
+        if (slot.hash == hash && slot.length == word.size() && equals_folded(slot.data, word)) {
+            slot.count += count;
+            return;
+        }
+    }
+}
+
+const WordCounter::Slot* WordCounter::find(uint64_t hash, std::string_view word) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+        const Slot& slot = slots_[index];
+        if (!slot.data) {
+            return nullptr;
+        }
+        if (slot.hash == hash && slot.length == word.size() && equals_folded(slot.data, word)) {
+            return &slot;
+        }
+    }
+}
+
+void WordCounter::merge(const WordCounter& other) {
+    other.for_each_hashed([this](uint64_t hash, std::string_view word, size_t count) {
+        add_hashed(hash, word, count);
+    });
+}
+
+void WordCounter::clear() {
+    if (slots_.size() > kRetainedSlots) {
+        std::vector<Slot>(kRetainedSlots).swap(slots_);
+        std::vector<uint32_t>().swap(used_);
+    } else {
+        for (uint32_t index : used_) {
+            slots_[index] = Slot{};
+        }
+        used_.clear();
+    }
+    if (arena_blocks_.size() > kRetainedArenaBlocks) {
+        arena_blocks_.resize(kRetainedArenaBlocks);
+        arena_block_sizes_.resize(kRetainedArenaBlocks);
+    }
+    size_ = 0;
+    arena_block_ = 0;
+    arena_used_ = 0;
+}
+
+size_t WordCounter::count(std::string_view word) const {
+    const Slot* slot = find(hash_folded(word), word);
+    return slot ? slot->count : 0;
+}
+
+std::vector<std::pair<std::string_view, size_t>> WordCounter::top(size_t k) const {
+    using Entry = std::pair<std::string_view, size_t>;
+    auto better = [](const Entry& a, const Entry& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    
+    // Max-heap under "better" keeps the worst of the current k on top.
+    std::vector<Entry> heap;
+    if (k == 0) {
+        return heap;
+    }
+    heap.reserve(std::min(k, size_));
+    
+    for_each([&](std::string_view word, size_t count) {
+        Entry entry(word, count);
+        if (heap.size() < k) {
+            heap.push_back(entry);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(entry, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = entry;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    });
+    
+    std::sort_heap(heap.begin(), heap.end(), better);
+    return heap;
+}
+
+size_t WordCounter::size() const {
+    return size_;
+}
+
+bool WordCounter::empty() const {
+    return size_ == 0;
+}
+
+const char* WordCounter::intern(std::string_view word) {
+    while (arena_block_ < arena_blocks_.size() &&
+           arena_used_ + word.size() > arena_block_sizes_[arena_block_]) {
+        ++arena_block_;
+        arena_used_ = 0;
+    }
+    
+    if (arena_block_ == arena_blocks_.size()) {
+        size_t block_size = std::max(kArenaBlockSize, word.size());
+        arena_blocks_.push_back(std::make_unique<char[]>(block_size));
+        arena_block_sizes_.push_back(block_size);
+        arena_used_ = 0;
+    }
+    
+    char* destination = arena_blocks_[arena_block_].get() + arena_used_;
+    for (size_t i = 0; i < word.size(); ++i) {
+        destination[i] = fold(word[i]);
+    }
+    arena_used_ += word.size();
+    return destination;
+}
+
+// Reinserts in insertion order, so used_ keeps that order.
+void WordCounter::grow() {
+    std::vector<Slot> old_slots(slots_.size() * 2);
+    old_slots.swap(slots_);
+    
+    size_t mask = slots_.size() - 1;
+    for (uint32_t& used : used_) {
+        const Slot& slot = old_slots[used];
+        size_t index = slot.hash & mask;
+        while (slots_[index].data) {
+            index = (index + 1) & mask;
+        }
+        slots_[index] = slot;
+        used = static_cast<uint32_t>(index);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../../include/common.h"
+
+// Word frequency table keyed case-insensitively (ASCII). Keys are folded
+// to lower case while hashing and interned once into an arena; the table
+// itself is open-addressed with linear probing. Counting a word that is
+// already present allocates nothing, and clear() keeps the table and the
+// arena for reuse, up to a retained size so one huge vocabulary does not
+// pin memory. The occupied slots are listed in insertion order, so
+// clear() and iteration cost the entries present, not the table size: a
+// small file after a large one does not pay for the large one's table.
+class WordCounter {
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        const char* data = nullptr;
+        uint32_t length = 0;
+        size_t count = 0;
+    };
+    
+    static constexpr size_t kInitialSlots = 256;
+    static constexpr size_t kArenaBlockSize = 64 * 1024;
+    static constexpr size_t kRetainedSlots = 1 << 16;
+    static constexpr size_t kRetainedArenaBlocks = 16;
+    
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> used_;
+    size_t size_;
+    std::vector<std::unique_ptr<char[]>> arena_blocks_;
+    std::vector<size_t> arena_block_sizes_;
+    size_t arena_block_;
+    size_t arena_used_;
+    
+public:
+    WordCounter();
+    
+    WordCounter(WordCounter&&) = default;
+    WordCounter& operator=(WordCounter&&) = default;
+    WordCounter(const WordCounter&) = delete;
+    WordCounter& operator=(const WordCounter&) = delete;
+    
+    void add(std::string_view word, size_t count = 1);
+    // add() for a word whose hash_folded() is already known.
+    void add_hashed(uint64_t hash, std::string_view word, size_t count);
+    void merge(const WordCounter& other);
+    void clear();
+    
+    size_t count(std::string_view word) const;
+    size_t size() const;
+    bool empty() const;
+    
+    // Calls fn(std::string_view word, size_t count) for every entry; the
+    // views stay valid until clear() or destruction.
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (uint32_t index : used_) {
+            const Slot& slot = slots_[index];
+            fn(std::string_view(slot.data, slot.length), slot.count);
+        }
+    }
+    
+    // Same, also passing each word's hash_folded() first.
+    template<typename Fn>
+    void for_each_hashed(Fn&& fn) const {
+        for (uint32_t index : used_) {
+            const Slot& slot = slots_[index];
+            fn(slot.hash, std::string_view(slot.data, slot.length), slot.count);
+        }
+    }
+    
+    // The k most frequent words, most frequent first, ties in word order.
+    // O(n log k) rather than sorting the whole table.
+    std::vector<std::pair<std::string_view, size_t>> top(size_t k) const;
+    
+    static uint64_t hash_folded(std::string_view word);
+    
+private:
+    const Slot* find(uint64_t hash, std::string_view word) const;
+    const char* intern(std::string_view word);
+    void grow();
+};
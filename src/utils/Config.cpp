@@ -1,4 +1,5 @@
 #include "Config.h"
+#include <cctype>
 
 std::unique_ptr<Config> Config::instance_ = nullptr;
 std::mutex Config::instance_mutex_;
@@ -11,14 +12,63 @@ Config& Config::getInstance() {
     return *instance_;
 }
 
+namespace {
+
+// Returns the offset one past the JSON value starting at pos.
+size_t findJsonValueEnd(const std::string& json, size_t pos) {
+    if (pos >= json.size()) {
+        return json.size();
+    }
+    
+    if (json[pos] == '"') {
+        for (size_t i = pos + 1; i < json.size(); ++i) {
+            if (json[i] == '\\') {
+                ++i;
+            } else if (json[i] == '"') {
+                return i + 1;
+            }
+        }
+        return json.size();
+    }
+    
+    if (json[pos] == '{' || json[pos] == '[') {
+        int depth = 0;
+        for (size_t i = pos; i < json.size(); ++i) {
+            if (json[i] == '"') {
+                i = findJsonValueEnd(json, i) - 1;
+            } else if (json[i] == '{' || json[i] == '[') {
+                ++depth;
+            } else if (json[i] == '}' || json[i] == ']') {
+                if (--depth == 0) {
+                    return i + 1;
+                }
+            }
+        }
+        return json.size();
+    }
+    
+    size_t end = json.find_first_of(",}]", pos);
+    return end == std::string::npos ? json.size() : end;
+}
+
+}
+
 bool Config::loadFromFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         return false;
     }
     
+    std::string content((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    if (trim(content).starts_with("{")) {
+        parseJsonValue("", content);
+        return true;
+    }
+    
+    std::istringstream stream(content);
     std::string line;
-    while (std::getline(file, line)) {
+    while (std::getline(stream, line)) {
         line = trim(line);
         if (line.empty() || line[0] == '#') {
             continue;
@@ -78,6 +128,81 @@ void Config::loadFromCommandLine(int argc, char* argv[]) {
     }
 }
 
+// Flattens nested objects into dotted keys, e.g. processing.queue_size.
+// Arrays are stored as their raw JSON text.
+void Config::parseJsonValue(const std::string& prefix, const std::string& json) {
+    size_t pos = json.find('{');
+    if (pos == std::string::npos) {
+        return;
+    }
+    ++pos;
+    
+    while (true) {
+        pos = json.find_first_not_of(" \t\r\n,", pos);
+        if (pos == std::string::npos || json[pos] != '"') {
+            return;
+        }
+        
+        size_t key_end = findJsonValueEnd(json, pos);
+        std::string key = json.substr(pos + 1, key_end - pos - 2);
+        std::string full_key = prefix.empty() ? key : prefix + "." + key;
+        
+        pos = json.find(':', key_end);
+        if (pos == std::string::npos) {
+            return;
+        }
+        pos = json.find_first_not_of(" \t\r\n", pos + 1);
+        if (pos == std::string::npos) {
+            return;
+        }
+        
+        size_t value_end = findJsonValueEnd(json, pos);
+        std::string value = trim(json.substr(pos, value_end - pos));
+        
+        if (value.starts_with("{")) {
+            parseJsonValue(full_key, value);
+        } else {
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.length() - 2);
+            }
+            set(full_key, value);
+        }
+        
+        pos = value_end;
+    }
+}
+
+size_t Config::getBytes(const std::string& key, size_t default_value) const {
+    std::string value = get<std::string>(key);
+    if (value.empty()) {
+        return default_value;
+    }
+    
+    size_t digits = 0;
+    while (digits < value.size() && std::isdigit(static_cast<unsigned char>(value[digits]))) {
+        ++digits;
+    }
+    if (digits == 0) {
+        return default_value;
+    }
+    
+    std::string unit = value.substr(digits);
+    std::transform(unit.begin(), unit.end(), unit.begin(), ::toupper);
+    
+    size_t multiplier = 1;
+    if (unit == "K" || unit == "KB") {
+        multiplier = size_t(1) << 10;
+    } else if (unit == "M" || unit == "MB") {
+        multiplier = size_t(1) << 20;
+    } else if (unit == "G" || unit == "GB") {
+        multiplier = size_t(1) << 30;
+    } else if (!unit.empty() && unit != "B") {
+        return default_value;
+    }
+    
+    return std::stoull(value.substr(0, digits)) * multiplier;
+}
+
 void Config::set(const std::string& key, const std::string& value) {
     std::lock_guard<std::mutex> lock(config_mutex_);
     config_map_[key] = value;
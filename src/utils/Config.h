@@ -28,6 +28,10 @@ public:
         return convertValue<T>(it->second);
     }
     
+    // Reads a size such as "10MB", "512K" or "1048576" (binary units).
+    // Malformed values return default_value.
+    size_t getBytes(const std::string& key, size_t default_value = 0) const;
+    
     void set(const std::string& key, const std::string& value);
     bool has(const std::string& key) const;
     void printAll() const;
@@ -39,6 +43,8 @@ private:
             return value;
         } else if constexpr (std::is_same_v<T, int>) {
             return std::stoi(value);
+        } else if constexpr (std::is_same_v<T, size_t>) {
+            return std::stoull(value);
         } else if constexpr (std::is_same_v<T, double>) {
             return std::stod(value);
         } else if constexpr (std::is_same_v<T, bool>) {
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "../../include/common.h"
+#include <cstring>
+
+// Streaming XXH64 of file contents. Fast enough to run at memory speed and
+// good enough to tell files apart; not meant to resist deliberate
+// collisions. Feeding the same bytes in any split gives the same digest.
+class ContentHasher {
+private:
+    static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+    
+    uint64_t lanes_[4];
+    uint64_t total_length_;
+    unsigned char pending_[32];
+    size_t pending_size_;
+    
+    static uint64_t rotl(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+    
+    static uint64_t read64(const unsigned char* data) {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    
+    static uint32_t read32(const unsigned char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    
+    static uint64_t round(uint64_t lane, uint64_t input) {
+        return rotl(lane + input * kPrime2, 31) * kPrime1;
+    }
+    
+    static uint64_t merge_round(uint64_t hash, uint64_t lane) {
+        return (hash ^ round(0, lane)) * kPrime1 + kPrime4;
+    }
+    
+    void consume_stripe(const unsigned char* data) {
+        lanes_[0] = round(lanes_[0], read64(data));
+        lanes_[1] = round(lanes_[1], read64(data + 8));
+        lanes_[2] = round(lanes_[2], read64(data + 16));
+        lanes_[3] = round(lanes_[3], read64(data + 24));
+    }
+    
+public:
+    explicit ContentHasher(uint64_t seed = 0) {
+        reset(seed);
+    }
+    
+    void reset(uint64_t seed = 0) {
+        lanes_[0] = seed + kPrime1 + kPrime2;
+        lanes_[1] = seed + kPrime2;
+        lanes_[2] = seed;
+        lanes_[3] = seed - kPrime1;
+        total_length_ = 0;
+        pending_size_ = 0;
+    }
+    
+    void update(std::string_view bytes) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(bytes.data());
+        size_t size = bytes.size();
+        total_length_ += size;
+        
+        if (pending_size_ > 0) {
+            size_t take = std::min(size, sizeof(pending_) - pending_size_);
+            std::memcpy(pending_ + pending_size_, data, take);
+            pending_size_ += take;
+            data += take;
+            size -= take;
+            if (pending_size_ < sizeof(pending_)) {
+                return;
+            }
+            consume_stripe(pending_);
+            pending_size_ = 0;
+        }
+        
+        for (; size >= 32; data += 32, size -= 32) {
+            consume_stripe(data);
+        }
+        
+        std::memcpy(pending_, data, size);
+        pending_size_ = size;
+    }
+    
+    uint64_t digest() const {
+        uint64_t hash;
+        if (total_length_ >= 32) {
+            hash = rotl(lanes_[0], 1) + rotl(lanes_[1], 7) + rotl(lanes_[2], 12) + rotl(lanes_[3], 18);
+            for (uint64_t lane : lanes_) {
+                hash = merge_round(hash, lane);
+            }
+        } else {
+            hash = lanes_[2] + kPrime5;
+        }
+        hash += total_length_;
+        
+        const unsigned char* data = pending_;
+        size_t size = pending_size_;
+        for (; size >= 8; data += 8, size -= 8) {
+            hash = rotl(hash ^ round(0, read64(data)), 27) * kPrime1 + kPrime4;
+        }
+        if (size >= 4) {
+            hash = rotl(hash ^ (uint64_t(read32(data)) * kPrime1), 23) * kPrime2 + kPrime3;
+            data += 4;
+            size -= 4;
+        }
+        for (; size > 0; ++data, --size) {
+            hash = rotl(hash ^ (*data * kPrime5), 11) * kPrime1;
+        }
+        
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+    
+    static uint64_t hash(std::string_view bytes) {
+        ContentHasher hasher;
+        hasher.update(bytes);
+        return hasher.digest();
+    }
+};
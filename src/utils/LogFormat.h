@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../../include/common.h"
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstring>
+
+// Builds one log message. Short messages stay in the inline buffer on the
+// caller's stack; longer ones spill into a string once.
+class LogBuffer {
+public:
+    static constexpr size_t kInlineSize = 512;
+    
+    LogBuffer() : size_(0) {}
+    LogBuffer(const LogBuffer&) = delete;
+    LogBuffer& operator=(const LogBuffer&) = delete;
+    
+    void append(std::string_view text) {
+        if (!overflow_.empty() || size_ + text.size() > kInlineSize) {
+            if (overflow_.empty()) {
+                overflow_.reserve(2 * (size_ + text.size()));
+                overflow_.assign(inline_, size_);
+            }
+            overflow_ += text;
+            return;
+        }
+        std::memcpy(inline_ + size_, text.data(), text.size());
+        size_ += text.size();
+    }
+    
+    template<typename T>
+    void append_value(const T& value) {
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            append(std::string_view(value));
+        } else if constexpr (std::is_same_v<T, char>) {
+            append(std::string_view(&value, 1));
+        } else if constexpr (std::is_same_v<T, bool>) {
+            append(value ? "true" : "false");
+        } else if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>) {
+            char digits[32];
+            std::to_chars_result converted;
+            if constexpr (std::is_floating_point_v<T>) {
+                converted = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+            } else {
+                converted = std::to_chars(digits, digits + sizeof(digits), value);
+            }
+            append(std::string_view(digits, static_cast<size_t>(converted.ptr - digits)));
+        } else if constexpr (std::is_enum_v<T>) {
+            append_value(static_cast<std::underlying_type_t<T>>(value));
+        } else {
+            static_assert(requires(std::ostream& os) { os << value; }, "type cannot be logged");
+            std::ostringstream oss;
+            oss << value;
+            append(oss.str());
+        }
+    }
+    
+    std::string_view view() const {
+        return overflow_.empty() ? std::string_view(inline_, size_) : std::string_view(overflow_);
+    }
+    
+private:
+    char inline_[kInlineSize];
+    size_t size_;
+    std::string overflow_;
+};
+
+// Called only when a format string and its arguments disagree. It is not
+// constexpr, so reaching it from the consteval constructor below turns the
+// mismatch into a compile error at the logging call.
+void log_format_argument_count_mismatch();
+
+// A format string whose "{}" placeholders are located at compile time and
+// checked against the argument count. Everything other than "{}" is copied
+// verbatim.
+template<typename... Args>
+class LogFormat {
+public:
+    template<typename S>
+        requires std::convertible_to<const S&, std::string_view>
+    consteval LogFormat(const S& format) : format_(format), placeholders_{} {
+        size_t count = 0;
+        for (size_t i = 0; i + 1 < format_.size(); ++i) {
+            if (format_[i] == '{' && format_[i + 1] == '}') {
+                if (count < sizeof...(Args)) {
+                    placeholders_[count] = i;
+                }
+                ++count;
+                ++i;
+            }
+        }
+        if (count != sizeof...(Args)) {
+            log_format_argument_count_mismatch();
+        }
+    }
+    
+    void render(LogBuffer& out, const Args&... args) const {
+        size_t literal = 0;
+        size_t index = 0;
+        [[maybe_unused]] auto put = [&](const auto& arg) {
+            out.append(format_.substr(literal, placeholders_[index] - literal));
+            out.append_value(arg);
+            literal = placeholders_[index] + 2;
+            ++index;
+        };
+        (put(args), ...);
+        out.append(format_.substr(literal));
+    }
+    
+    std::string_view str() const { return format_; }
+    
+private:
+    std::string_view format_;
+    std::array<size_t, sizeof...(Args)> placeholders_;
+};
@@ -1,20 +1,37 @@
 #include "Logger.h"
+#include <ctime>
 
 std::unique_ptr<Logger> Logger::instance_ = nullptr;
 std::mutex Logger::instance_mutex_;
 
-Logger::Logger() : current_level_(LogLevel::INFO), console_output_(true) {}
+namespace {
 
+constexpr size_t kMaxBatchBytes = 64 * 1024;
+
+}
+
+Logger::Logger()
+    : log_file_size_(0), max_file_size_(0), max_rotated_files_(0), current_level_(LogLevel::INFO),
+      console_output_(true), async_(false) {}
+
+Logger::~Logger() {
+    setAsync(false);
+}
+
+// The lock is taken once; later calls only pay the static guard check,
+// which matters now that every LOG_* call site asks for the instance.
 Logger& Logger::getInstance() {
-    std::lock_guard<std::mutex> lock(instance_mutex_);
-    if (!instance_) {
-        instance_ = std::unique_ptr<Logger>(new Logger());
-    }
-    return *instance_;
+    static Logger* instance = [] {
+        std::lock_guard<std::mutex> lock(instance_mutex_);
+        if (!instance_) {
+            instance_ = std::unique_ptr<Logger>(new Logger());
+        }
+        return instance_.get();
+    }();
+    return *instance;
 }
 
 void Logger::setLevel(LogLevel level) {
-    std::lock_guard<std::mutex> lock(log_mutex_);
     current_level_ = level;
 }
 
@@ -29,41 +46,91 @@ void Logger::setLogFile(const std::string& filename) {
         log_file_.close();
     }
     log_file_.open(filename, std::ios::app);
+    log_file_name_ = filename;
+    
+    std::error_code ec;
+    log_file_size_ = fs::exists(filename, ec) ? fs::file_size(filename, ec) : 0;
 }
 
-void Logger::log(LogLevel level, const std::string& message) {
-    if (level < current_level_) {
+void Logger::setRotation(size_t max_file_size, size_t max_files) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    max_file_size_ = max_file_size;
+    max_rotated_files_ = std::max<size_t>(max_files, 1);
+}
+
+void Logger::setAsync(bool enable, size_t queue_capacity) {
+    if (enable == async_.load()) {
         return;
     }
     
-    std::lock_guard<std::mutex> lock(log_mutex_);
-    
-    std::string log_entry = "[" + getCurrentTimestamp() + "] " + 
-                           "[" + levelToString(level) + "] " + message;
+    if (enable) {
+        queue_ = std::make_unique<LockFreeQueue<LogRecord>>(queue_capacity);
+        writer_ = std::thread(&Logger::writer_loop, this);
+        async_ = true;
+    } else {
+        async_ = false;
+        LogRecord stop;
+        stop.stop = true;
+        queue_->push(std::move(stop));
+        writer_.join();
+        queue_.reset();
+    }
+}
+
+void Logger::flush() {
+    if (!async_.load()) {
+        return;
+    }
     
-    if (console_output_) {
-        std::cout << log_entry << std::endl;
+    std::promise<void> flushed;
+    std::future<void> done = flushed.get_future();
+    LogRecord record;
+    record.flushed = &flushed;
+    queue_->push(std::move(record));
+    done.wait();
+}
+
+void Logger::log(LogLevel level, std::string_view message) {
+    if (!isEnabled(level)) {
+        return;
     }
     
-    if (log_file_.is_open()) {
-        log_file_ << log_entry << std::endl;
-        log_file_.flush();
+    std::string log_entry;
+    log_entry.reserve(message.size() + 36);
+    log_entry += '[';
+    log_entry += getCurrentTimestamp();
+    log_entry += "] [";
+    log_entry += levelToString(level);
+    log_entry += "] ";
+    log_entry += message;
+    log_entry += '\n';
+    
+    if (async_.load(std::memory_order_acquire)) {
+        // The push wakes the writer, so an error goes out with its next
+        // batch without holding up the thread that hit it.
+        LogRecord record;
+        record.text = std::move(log_entry);
+        queue_->push(std::move(record));
+        return;
     }
+    
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    write_entries(log_entry);
 }
 
-void Logger::debug(const std::string& message) {
+void Logger::debug(std::string_view message) {
     log(LogLevel::DEBUG, message);
 }
 
-void Logger::info(const std::string& message) {
+void Logger::info(std::string_view message) {
     log(LogLevel::INFO, message);
 }
 
-void Logger::warning(const std::string& message) {
+void Logger::warning(std::string_view message) {
     log(LogLevel::WARNING, message);
 }
 
-void Logger::error(const std::string& message) {
+void Logger::error(std::string_view message) {
     log(LogLevel::ERROR, message);
 }
 
@@ -77,14 +144,98 @@ std::string Logger::levelToString(LogLevel level) {
     }
 }
 
+// The date and time are formatted once per second per thread; only the
+// milliseconds change between calls within that second.
 std::string Logger::getCurrentTimestamp() {
+    thread_local time_t cached_second = -1;
+    thread_local char cached_prefix[32];
+    
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         now.time_since_epoch()) % 1000;
     
-    std::ostringstream oss;
-    oss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    oss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    return oss.str();
-}
\ No newline at end of file
+    if (time_t != cached_second) {
+        struct tm local;
+        localtime_r(&time_t, &local);
+        std::strftime(cached_prefix, sizeof(cached_prefix), "%Y-%m-%d %H:%M:%S", &local);
+        cached_second = time_t;
+    }
+    
+    char millis[5] = {'.', char('0' + ms.count() / 100), char('0' + ms.count() / 10 % 10),
+                      char('0' + ms.count() % 10), '\0'};
+    return std::string(cached_prefix) + millis;
+}
+
+// Requires log_mutex_. entries is one or more complete lines.
+void Logger::write_entries(const std::string& entries) {
+    if (console_output_) {
+        std::cout.write(entries.data(), static_cast<std::streamsize>(entries.size()));
+        std::cout.flush();
+    }
+    
+    if (log_file_.is_open()) {
+        rotate_if_needed(entries.size());
+        log_file_.write(entries.data(), static_cast<std::streamsize>(entries.size()));
+        log_file_.flush();
+        log_file_size_ += entries.size();
+    }
+}
+
+// Requires log_mutex_.
+void Logger::rotate_if_needed(size_t incoming) {
+    if (max_file_size_ == 0 || log_file_size_ == 0 || log_file_size_ + incoming <= max_file_size_) {
+        return;
+    }
+    
+    log_file_.close();
+    
+    std::error_code ec;
+    for (size_t i = max_rotated_files_; i > 1; --i) {
+        std::string older = log_file_name_ + "." + std::to_string(i - 1);
+        if (fs::exists(older, ec)) {
+            fs::rename(older, log_file_name_ + "." + std::to_string(i), ec);
+        }
+    }
+    fs::rename(log_file_name_, log_file_name_ + ".1", ec);
+    
+    log_file_.open(log_file_name_, std::ios::trunc);
+    log_file_size_ = 0;
+}
+
+void Logger::writer_loop() {
+    std::string batch;
+    std::vector<std::promise<void>*> waiters;
+    
+    while (true) {
+        LogRecord record;
+        queue_->wait_and_pop(record);
+        
+        bool stop = false;
+        batch.clear();
+        waiters.clear();
+        
+        // Take everything already queued (up to a batch) so one write and
+        // one flush cover many lines.
+        do {
+            batch += record.text;
+            if (record.flushed) {
+                waiters.push_back(record.flushed);
+            }
+            stop = stop || record.stop;
+        } while (batch.size() < kMaxBatchBytes && queue_->try_pop(record));
+        
+        if (!batch.empty()) {
+            std::lock_guard<std::mutex> lock(log_mutex_);
+            write_entries(batch);
+        }
+        
+        for (auto* waiter : waiters) {
+            waiter->set_value();
+        }
+        
+        if (stop) {
+            return;
+        }
+    }
+}
@@ -1,61 +1,117 @@
 #pragma once
 
 #include "../../include/common.h"
+#include "LogFormat.h"
+
+// Levels below LOG_MIN_LEVEL are compiled out of the LOG_* macros. Release
+// builds drop DEBUG; pass -DLOG_MIN_LEVEL=<n> to change that.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 1
+#else
+#define LOG_MIN_LEVEL 0
+#endif
+#endif
+
+inline constexpr LogLevel kMinLogLevel = static_cast<LogLevel>(LOG_MIN_LEVEL);
 
 class Logger {
 private:
+    // One queued line for the background writer. A record with flushed set
+    // asks the writer to signal once everything before it is on disk; stop
+    // ends the writer.
+    struct LogRecord {
+        std::string text;
+        std::promise<void>* flushed = nullptr;
+        bool stop = false;
+    };
+    
     static std::unique_ptr<Logger> instance_;
     static std::mutex instance_mutex_;
     
     std::mutex log_mutex_;
     std::ofstream log_file_;
-    LogLevel current_level_;
+    std::string log_file_name_;
+    size_t log_file_size_;
+    size_t max_file_size_;
+    size_t max_rotated_files_;
+    std::atomic<LogLevel> current_level_;
     bool console_output_;
     
+    std::atomic<bool> async_;
+    std::unique_ptr<LockFreeQueue<LogRecord>> queue_;
+    std::thread writer_;
+    
     Logger();
     
 public:
+    ~Logger();
+    
     static Logger& getInstance();
     
     void setLevel(LogLevel level);
     void setConsoleOutput(bool enable);
     void setLogFile(const std::string& filename);
     
-    void log(LogLevel level, const std::string& message);
-    void debug(const std::string& message);
-    void info(const std::string& message);
-    void warning(const std::string& message);
-    void error(const std::string& message);
+    // Once the log file would grow past max_file_size it is renamed to
+    // <file>.1 (older copies shift up to <file>.<max_files>) and a new one
+    // is started. max_file_size == 0 turns rotation off.
+    void setRotation(size_t max_file_size, size_t max_files = 5);
+    
+    // In async mode log() only formats the line and queues it; a background
+    // thread writes queued lines in batches and flushes once per batch.
+    // Only flush() waits until everything queued is written; the
+    // destructor drains the queue. Switch modes only while no other thread
+    // is logging.
+    void setAsync(bool enable, size_t queue_capacity = 8192);
+    void flush();
+    
+    bool isEnabled(LogLevel level) const {
+        return level >= current_level_.load(std::memory_order_relaxed);
+    }
+    
+    void log(LogLevel level, std::string_view message);
+    void debug(std::string_view message);
+    void info(std::string_view message);
+    void warning(std::string_view message);
+    void error(std::string_view message);
     
+    // Formats into a stack buffer; see LogFormat for the format syntax.
+    // Callers that may be filtered out should use the LOG_* macros, which
+    // skip evaluating the arguments as well.
     template<typename... Args>
-    void logf(LogLevel level, const std::string& format, Args... args) {
-        std::ostringstream oss;
-        logf_impl(oss, format, args...);
-        log(level, oss.str());
+    void logf(LogLevel level, LogFormat<std::decay_t<Args>...> format, Args&&... args) {
+        if (!isEnabled(level)) {
+            return;
+        }
+        LogBuffer buffer;
+        format.render(buffer, args...);
+        log(level, buffer.view());
     }
     
 private:
     std::string levelToString(LogLevel level);
     std::string getCurrentTimestamp();
     
-    template<typename T>
-    void logf_impl(std::ostringstream& oss, const std::string& format, T&& t) {
-        size_t pos = format.find("{}");
-        if (pos != std::string::npos) {
-            oss << format.substr(0, pos) << std::forward<T>(t) << format.substr(pos + 2);
-        } else {
-            oss << format;
-        }
-    }
-    
-    template<typename T, typename... Args>
-    void logf_impl(std::ostringstream& oss, const std::string& format, T&& t, Args&&... args) {
-        size_t pos = format.find("{}");
-        if (pos != std::string::npos) {
-            std::string new_format = format.substr(0, pos) + std::to_string(t) + format.substr(pos + 2);
-            logf_impl(oss, new_format, std::forward<Args>(args)...);
-        } else {
-            oss << format;
-        }
-    }
-};
\ No newline at end of file
+    void write_entries(const std::string& entries);
+    void rotate_if_needed(size_t incoming);
+    void writer_loop();
+};
+
+// The format is checked at compile time, and the arguments are evaluated
+// only when the level is enabled:
+//     LOG_INFO("Found {} files in {}", count, path);
+#define LOG_AT(level, ...)                                              \
+    do {                                                                \
+        if constexpr ((level) >= kMinLogLevel) {                        \
+            Logger& log_at_logger = Logger::getInstance();              \
+            if (log_at_logger.isEnabled(level)) {                       \
+                log_at_logger.logf((level), __VA_ARGS__);               \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERROR, __VA_ARGS__)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../include/common.h"
+#include <ctime>
 
 class Timer {
 private:
@@ -47,6 +48,15 @@ public:
     }
 };
 
+// CPU time consumed by the calling thread. Unlike wall time it does not
+// grow while the thread is descheduled, so it measures a task's own work
+// even when there are more workers than cores.
+inline std::chrono::microseconds thread_cpu_time() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::microseconds(static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000);
+}
+
 class ScopedTimer {
 private:
     Timer& timer_;
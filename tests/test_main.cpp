@@ -4,6 +4,7 @@
 #include "../src/observers/ProgressMonitor.h"
 #include <cassert>
 #include <fstream>
+#include <thread>
 
 void test_logger() {
     std::cout << "Testing Logger functionality...\n";
@@ -34,6 +35,209 @@ void test_logger() {
     fs::remove("test.log");
 }
 
+std::vector<std::string> read_lines(const std::string& path) {
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void test_async_logger() {
+    std::cout << "Testing async logger...\n";
+    
+    fs::remove("async_test.log");
+    Logger& logger = Logger::getInstance();
+    logger.setLevel(LogLevel::INFO);
+    logger.setConsoleOutput(false);
+    logger.setLogFile("async_test.log");
+    logger.setAsync(true, 64);
+    
+    const int threads = 4;
+    const int per_thread = 2000;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&logger, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                logger.info("writer " + std::to_string(t) + " line " + std::to_string(i));
+                logger.debug("filtered");
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    
+    // Everything queued, the error included, is on disk once flush()
+    // returns.
+    logger.error("final error");
+    logger.flush();
+    std::vector<std::string> lines = read_lines("async_test.log");
+    assert(lines.size() == threads * per_thread + 1);
+    assert(lines.back().find("[ERROR] final error") != std::string::npos);
+    
+    // Lines from one thread keep their order.
+    std::vector<int> next(threads, 0);
+    for (const auto& line : lines) {
+        assert(line.find("filtered") == std::string::npos);
+        size_t pos = line.find("writer ");
+        if (pos == std::string::npos) {
+            continue;
+        }
+        int t = std::stoi(line.substr(pos + 7));
+        int i = std::stoi(line.substr(line.find("line ") + 5));
+        assert(i == next[t]);
+        next[t]++;
+    }
+    
+    logger.info("before switching back");
+    logger.setAsync(false);
+    assert(read_lines("async_test.log").size() == threads * per_thread + 2);
+    
+    std::cout << "✓ Async logger keeps every line in per-thread order\n";
+    fs::remove("async_test.log");
+    
+    // Rotation keeps each file under the limit and shifts older copies.
+    fs::remove("rotate_test.log");
+    for (int i = 1; i <= 3; ++i) {
+        fs::remove("rotate_test.log." + std::to_string(i));
+    }
+    logger.setLogFile("rotate_test.log");
+    logger.setRotation(2000, 2);
+    for (int i = 0; i < 200; ++i) {
+        logger.info("rotation line " + std::to_string(i));
+    }
+    assert(fs::file_size("rotate_test.log") <= 2000);
+    assert(fs::file_size("rotate_test.log.1") <= 2000);
+    assert(fs::exists("rotate_test.log.2"));
+    assert(!fs::exists("rotate_test.log.3"));
+    assert(read_lines("rotate_test.log").back().find("rotation line 199") != std::string::npos);
+    
+    logger.setRotation(0);
+    logger.setConsoleOutput(true);
+    fs::remove("rotate_test.log");
+    fs::remove("rotate_test.log.1");
+    fs::remove("rotate_test.log.2");
+    
+    Config& config = Config::getInstance();
+    config.set("size.plain", "4096");
+    config.set("size.mb", "10MB");
+    config.set("size.k", "512k");
+    config.set("size.bad", "lots");
+    assert(config.getBytes("size.plain") == 4096);
+    assert(config.getBytes("size.mb") == 10u << 20);
+    assert(config.getBytes("size.k") == 512u << 10);
+    assert(config.getBytes("size.bad", 7) == 7);
+    assert(config.getBytes("size.missing", 9) == 9);
+    
+    std::cout << "✓ Log rotation honours max_file_size\n";
+}
+
+void test_log_format() {
+    std::cout << "Testing compile-time log formats...\n";
+    
+    LogBuffer buffer;
+    LogFormat<std::string, int, double, bool, char, const char*> format("{} has {} at {} ({}) {}{}");
+    format.render(buffer, std::string("file.txt"), -42, 2.5, true, '!', "done");
+    assert(buffer.view() == "file.txt has -42 at 2.5 (true) !done");
+    
+    LogBuffer plain;
+    LogFormat<> literal("no placeholders {here");
+    literal.render(plain);
+    assert(plain.view() == "no placeholders {here");
+    
+    // Messages longer than the inline buffer spill over intact.
+    std::string long_text(LogBuffer::kInlineSize + 100, 'x');
+    LogBuffer spilled;
+    LogFormat<std::string, size_t> long_format("[{}] {}");
+    long_format.render(spilled, long_text, size_t(7));
+    assert(spilled.view() == "[" + long_text + "] 7");
+    
+    // Disabled levels never evaluate their arguments.
+    fs::remove("format_test.log");
+    Logger& logger = Logger::getInstance();
+    logger.setConsoleOutput(false);
+    logger.setLogFile("format_test.log");
+    logger.setLevel(LogLevel::WARNING);
+    
+    int evaluated = 0;
+    auto expensive = [&evaluated]() {
+        ++evaluated;
+        return std::string("value");
+    };
+    LOG_INFO("filtered {}", expensive());
+    LOG_DEBUG("filtered {}", expensive());
+    assert(evaluated == 0);
+    
+    LOG_WARNING("kept {} {}", expensive(), 3);
+    assert(evaluated == 1);
+    
+    std::vector<std::string> lines = read_lines("format_test.log");
+    assert(lines.size() == 1);
+    assert(lines[0].find("[WARN] kept value 3") != std::string::npos);
+    
+    logger.setLevel(LogLevel::INFO);
+    logger.setConsoleOutput(true);
+    fs::remove("format_test.log");
+    
+    std::cout << "✓ Log formats render correctly and skip disabled levels\n";
+}
+
+void benchmark_logger() {
+    std::cout << "Benchmarking sync vs async logging...\n";
+    
+    Logger& logger = Logger::getInstance();
+    logger.setConsoleOutput(false);
+    logger.setLogFile("bench_test.log");
+    
+    for (bool async : {false, true}) {
+        logger.setAsync(async);
+        
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&logger]() {
+                for (int i = 0; i < 25000; ++i) {
+                    LOG_INFO("benchmark line {}", i);
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        logger.flush();
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        
+        std::cout << "  - " << (async ? "async" : "sync ") << ": " << elapsed.count() << "ms for 100000 lines\n";
+    }
+    
+    // A filtered call costs a level check; the arguments are never built.
+    logger.setLevel(LogLevel::WARNING);
+    const int filtered_calls = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < filtered_calls; ++i) {
+        logger.info("filtered line " + std::to_string(i));
+    }
+    auto concatenated = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < filtered_calls; ++i) {
+        LOG_INFO("filtered line {}", i);
+    }
+    auto gated = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    logger.setLevel(LogLevel::INFO);
+    
+    std::cout << "  - filtered, concatenated: " << concatenated.count() << "ms for " << filtered_calls << " calls\n";
+    std::cout << "  - filtered, LOG_INFO:     " << gated.count() << "ms for " << filtered_calls << " calls\n";
+    
+    logger.setAsync(false);
+    logger.setConsoleOutput(true);
+    fs::remove("bench_test.log");
+    std::cout << "✓ Logger benchmark completed\n";
+}
+
 void test_config() {
     std::cout << "Testing Config functionality...\n";
     
@@ -100,17 +304,170 @@ void test_progress_monitor() {
     ProgressMonitor monitor(false);
     monitor.set_totals(3, 300);
     
-    ProgressEvent event1("file1.txt", 100, 100, "completed");
-    ProgressEvent event2("file2.txt", 100, 100, "completed");
-    ProgressEvent event3("file3.txt", 100, 100, "completed");
+    // Bytes are deltas, so a file reported in several events counts once.
+    monitor.notify(ProgressEvent{1, 0, 100, ProgressStatus::STARTED});
+    monitor.notify(ProgressEvent{1, 60, 100, ProgressStatus::PROCESSING});
+    monitor.notify(ProgressEvent{1, 40, 100, ProgressStatus::COMPLETED});
+    monitor.notify(ProgressEvent{2, 100, 100, ProgressStatus::COMPLETED});
+    monitor.notify(ProgressEvent{3, 100, 100, ProgressStatus::FAILED});
+    
+    assert(monitor.completed_files() == 2);
+    assert(monitor.processed_bytes() == 300);
+    
+    // Counters from many threads add up while the render thread redraws.
+    monitor.set_totals(3 + 4 * 1000, 300 + 4 * 1000 * 10);
+    monitor.start_rendering(std::chrono::milliseconds(5));
+    std::vector<std::thread> notifiers;
+    for (int t = 0; t < 4; ++t) {
+        notifiers.emplace_back([&monitor, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                monitor.notify(ProgressEvent{uint64_t(t * 1000 + i), 10, 10, ProgressStatus::COMPLETED});
+            }
+        });
+    }
+    for (auto& notifier : notifiers) {
+        notifier.join();
+    }
+    monitor.stop_rendering();
+    std::cout << "\n";
     
-    monitor.notify(event1);
-    monitor.notify(event2);
-    monitor.notify(event3);
+    assert(monitor.completed_files() == 4002);
+    assert(monitor.processed_bytes() == 40300);
     
     std::cout << "✓ ProgressMonitor works correctly\n";
 }
 
+struct CountingObserver : Observer<int> {
+    std::atomic<long> total{0};
+    
+    void notify(const int& value) override {
+        total.fetch_add(value, std::memory_order_relaxed);
+    }
+};
+
+// Attaches another observer the first time it is notified.
+class AttachingObserver : public Observer<int> {
+public:
+    AttachingObserver(Subject<int>& subject, std::shared_ptr<Observer<int>> next)
+        : subject_(subject), next_(std::move(next)) {}
+    
+    void notify(const int&) override {
+        if (next_) {
+            subject_.attach(std::move(next_));
+        }
+    }
+
+private:
+    Subject<int>& subject_;
+    std::shared_ptr<Observer<int>> next_;
+};
+
+void test_subject_snapshots() {
+    std::cout << "Testing Subject snapshot notification...\n";
+    
+    Subject<int> subject;
+    subject.notify_all(1);
+    assert(subject.observer_count() == 0);
+    
+    auto first = std::make_shared<CountingObserver>();
+    auto second = std::make_shared<CountingObserver>();
+    subject.attach(first);
+    subject.attach(second);
+    subject.notify_all(2);
+    assert(first->total == 2 && second->total == 2);
+    
+    subject.detach(second);
+    subject.notify_all(3);
+    assert(first->total == 5 && second->total == 2);
+    assert(subject.observer_count() == 1);
+    
+    // An observer nobody else owns is skipped and pruned.
+    std::weak_ptr<CountingObserver> dropped = first;
+    first.reset();
+    assert(subject.observer_count() == 0);
+    subject.notify_all(4);
+    assert(dropped.expired());
+    
+    // Attaching from inside a notification leaves the replaced list
+    // retired; an observer dropped meanwhile still counts as expired.
+    auto late = std::make_shared<CountingObserver>();
+    auto attacher = std::make_shared<AttachingObserver>(subject, late);
+    auto kept = std::make_shared<CountingObserver>();
+    subject.attach(attacher);
+    subject.attach(kept);
+    subject.notify_all(1);
+    assert(subject.observer_count() == 3);
+    std::weak_ptr<CountingObserver> dropped_kept = kept;
+    kept.reset();
+    assert(subject.observer_count() == 2);
+    subject.notify_all(1);
+    assert(dropped_kept.expired() && late->total == 1);
+    subject.detach(attacher);
+    subject.detach(late);
+    
+    // Notifiers keep running while observers come and go.
+    auto steady = std::make_shared<CountingObserver>();
+    subject.attach(steady);
+    std::atomic<bool> stop{false};
+    std::thread churn([&subject, &stop]() {
+        while (!stop.load()) {
+            auto transient = std::make_shared<CountingObserver>();
+            subject.attach(transient);
+            subject.detach(transient);
+        }
+    });
+    
+    std::vector<std::thread> notifiers;
+    for (int t = 0; t < 4; ++t) {
+        notifiers.emplace_back([&subject]() {
+            for (int i = 0; i < 10000; ++i) {
+                subject.notify_all(1);
+            }
+        });
+    }
+    for (auto& notifier : notifiers) {
+        notifier.join();
+    }
+    stop = true;
+    churn.join();
+    
+    assert(steady->total == 40000);
+    assert(subject.observer_count() == 1);
+    
+    std::cout << "✓ Subject notifies from snapshots while observers change\n";
+}
+
+void benchmark_subject_notify() {
+    std::cout << "Benchmarking Subject notification...\n";
+    
+    Subject<int> subject;
+    std::vector<std::shared_ptr<CountingObserver>> observers;
+    for (int i = 0; i < 2; ++i) {
+        observers.push_back(std::make_shared<CountingObserver>());
+        subject.attach(observers.back());
+    }
+    
+    for (int threads : {1, 4}) {
+        const int per_thread = 1000000 / threads;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> notifiers;
+        for (int t = 0; t < threads; ++t) {
+            notifiers.emplace_back([&subject, per_thread]() {
+                for (int i = 0; i < per_thread; ++i) {
+                    subject.notify_all(1);
+                }
+            });
+        }
+        for (auto& notifier : notifiers) {
+            notifier.join();
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        std::cout << "  - " << threads << " thread(s): " << elapsed.count() << "ms for 1000000 notifications\n";
+    }
+    
+    std::cout << "✓ Subject benchmark completed\n";
+}
+
 void test_thread_safe_queue() {
     std::cout << "Testing ThreadSafeQueue functionality...\n";
     
@@ -178,6 +535,148 @@ void test_concurrent_queue_access() {
     std::cout << "✓ Concurrent queue access works correctly\n";
 }
 
+void test_bounded_queue() {
+    std::cout << "Testing bounded ThreadSafeQueue...\n";
+    
+    ThreadSafeQueue<int> queue(2);
+    assert(queue.capacity() == 2);
+    
+    assert(queue.try_push(1));
+    assert(queue.try_push(2));
+    assert(!queue.try_push(3));
+    assert(queue.size() == 2);
+    
+    std::atomic<bool> pushed{false};
+    std::thread producer([&queue, &pushed]() {
+        queue.push(3);
+        pushed = true;
+    });
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(!pushed.load());
+    
+    int item;
+    queue.wait_and_pop(item);
+    assert(item == 1);
+    
+    producer.join();
+    assert(pushed.load());
+    assert(queue.size() == 2);
+    
+    std::cout << "✓ Bounded queue applies backpressure\n";
+}
+
+void test_lock_free_queue() {
+    std::cout << "Testing LockFreeQueue functionality...\n";
+    
+    LockFreeQueue<std::unique_ptr<int>> queue(3);
+    assert(queue.capacity() == 4);
+    assert(queue.empty());
+    
+    for (int i = 0; i < 4; ++i) {
+        assert(queue.try_push(std::make_unique<int>(i)));
+    }
+    
+    auto rejected = std::make_unique<int>(99);
+    assert(!queue.try_push(std::move(rejected)));
+    assert(rejected && *rejected == 99);
+    assert(queue.size() == 4);
+    
+    std::unique_ptr<int> item;
+    assert(queue.try_pop(item));
+    assert(*item == 0);
+    queue.wait_and_pop(item);
+    assert(*item == 1);
+    assert(queue.size() == 2);
+    
+    std::cout << "✓ LockFreeQueue works correctly\n";
+}
+
+void test_concurrent_lock_free_queue() {
+    std::cout << "Testing concurrent LockFreeQueue access...\n";
+    
+    LockFreeQueue<int> queue(16);
+    std::atomic<long> sum{0};
+    std::vector<std::thread> threads;
+    const int producers = 4;
+    const int consumers = 4;
+    const int per_producer = 5000;
+    
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&queue, i]() {
+            for (int j = 0; j < per_producer; ++j) {
+                queue.push(i * per_producer + j);
+            }
+        });
+    }
+    
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&queue, &sum]() {
+            int item;
+            for (int j = 0; j < producers * per_producer / consumers; ++j) {
+                queue.wait_and_pop(item);
+                sum += item;
+            }
+        });
+    }
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    long total = static_cast<long>(producers) * per_producer;
+    assert(sum.load() == total * (total - 1) / 2);
+    assert(queue.empty());
+    
+    std::cout << "✓ Concurrent LockFreeQueue access works correctly\n";
+}
+
+template<typename Queue>
+double run_queue_contention(size_t pairs, int items_per_producer) {
+    Queue queue(1024);
+    std::vector<std::thread> threads;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    for (size_t i = 0; i < pairs; ++i) {
+        threads.emplace_back([&queue, items_per_producer]() {
+            for (int j = 0; j < items_per_producer; ++j) {
+                queue.push(j);
+            }
+        });
+        threads.emplace_back([&queue, items_per_producer]() {
+            int item;
+            for (int j = 0; j < items_per_producer; ++j) {
+                queue.wait_and_pop(item);
+            }
+        });
+    }
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void benchmark_queue_contention() {
+    std::cout << "Benchmarking queue contention (mutex vs lock-free)...\n";
+    
+    const int total_items = 200000;
+    
+    for (size_t pairs : {1, 2, 4, 8, 16}) {
+        int per_producer = total_items / static_cast<int>(pairs);
+        double mutex_ms = run_queue_contention<ThreadSafeQueue<int>>(pairs, per_producer);
+        double lock_free_ms = run_queue_contention<LockFreeQueue<int>>(pairs, per_producer);
+        
+        std::cout << "  - " << pairs << " producers / " << pairs << " consumers: mutex "
+                  << mutex_ms << "ms, lock-free " << lock_free_ms << "ms\n";
+    }
+    
+    std::cout << "✓ Queue contention benchmark completed\n";
+}
+
 void test_processing_stats() {
     std::cout << "Testing ProcessingStats functionality...\n";
     
@@ -229,23 +728,58 @@ void test_config_file_loading() {
     fs::remove("test_config.conf");
 }
 
+void test_json_config_loading() {
+    std::cout << "Testing JSON config file loading...\n";
+    
+    std::ofstream config_file("test_config.json");
+    config_file << "{\n";
+    config_file << "  \"processing\": {\n";
+    config_file << "    \"queue_size\": 64,\n";
+    config_file << "    \"tags\": [\"a\", \"b\"]\n";
+    config_file << "  },\n";
+    config_file << "  \"logging\": { \"level\": \"INFO\", \"rotation\": true }\n";
+    config_file << "}\n";
+    config_file.close();
+    
+    Config& config = Config::getInstance();
+    assert(config.loadFromFile("test_config.json"));
+    assert(config.get<int>("processing.queue_size") == 64);
+    assert(config.get<std::string>("processing.tags") == "[\"a\", \"b\"]");
+    assert(config.get<std::string>("logging.level") == "INFO");
+    assert(config.get<bool>("logging.rotation") == true);
+    
+    std::cout << "✓ JSON config loading works correctly\n";
+    
+    fs::remove("test_config.json");
+}
+
 int main() {
     std::cout << "=== Utility Components Test Suite ===\n\n";
     
     try {
         test_logger();
+        test_async_logger();
+        test_log_format();
         test_config();
         test_timer();
         test_scoped_timer();
         test_progress_monitor();
+        test_subject_snapshots();
         test_thread_safe_queue();
         test_concurrent_queue_access();
+        test_bounded_queue();
+        test_lock_free_queue();
+        test_concurrent_lock_free_queue();
         test_processing_stats();
         test_config_file_loading();
+        test_json_config_loading();
+        benchmark_queue_contention();
+        benchmark_logger();
+        benchmark_subject_notify();
         
         std::cout << "\n✅ All utility tests passed!\n";
         return 0;
-        
+    
     } catch (const std::exception& e) {
         std::cerr << "❌ Test failed: " << e.what() << std::endl;
         return 1;
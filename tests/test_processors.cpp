@@ -1,8 +1,40 @@
 #include "../src/processors/TextProcessor.h"
+#include "../src/core/ThreadPool.h"
+#include "../src/core/ProcessorPool.h"
+#include "../src/core/DirectoryWalker.h"
+#include "../src/core/FileBatcher.h"
+#include "../src/core/ReadEngine.h"
+#include "../src/core/Manifest.h"
+#include "../src/core/Deduplicator.h"
+#include "../src/core/DirectoryWatcher.h"
+#include "../src/core/ReportWriter.h"
+#include "../src/core/ResultsStore.h"
+#include "../src/utils/ContentHash.h"
 #include "../src/observers/ProgressMonitor.h"
 #include "../src/utils/Logger.h"
 #include <cassert>
 #include <fstream>
+#include <map>
+#include <cmath>
+#include <random>
+
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
 
 void create_test_file(const std::string& filename, const std::string& content) {
     std::ofstream file(filename);
@@ -73,6 +105,1264 @@ void test_text_processor_with_observer() {
     fs::remove_all("./test_output");
 }
 
+void test_streaming_chunk_boundaries() {
+    std::cout << "Testing streaming analysis across chunk boundaries...\n";
+    
+    const std::string test_content =
+        "Hello, World!\n"
+        "\n"
+        "foo-bar baz\n"
+        "  \n"
+        "last line";
+    
+    create_test_file("test_stream.txt", test_content);
+    
+    for (size_t chunk_size : {1, 3, 7, 1024}) {
+        TextProcessor processor("./test_output", chunk_size);
+        ProcessResult result = processor.process("test_stream.txt");
+        
+        assert(result.success);
+        assert(result.metadata["lines"] == "5");
+        assert(result.metadata["words"] == "6");
+        assert(result.metadata["characters"] == std::to_string(test_content.size()));
+        
+        std::ifstream report(result.metadata["output_file"]);
+        std::string report_text((std::istreambuf_iterator<char>(report)),
+                                std::istreambuf_iterator<char>());
+        assert(report_text.find("Paragraphs: 2\n") != std::string::npos);
+    }
+    
+    std::cout << "✓ Results are independent of chunk size\n";
+    
+    fs::remove("test_stream.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_mmap_input_mode() {
+    std::cout << "Testing memory-mapped input mode...\n";
+    
+    std::string content;
+    for (int i = 0; i < 200; ++i) {
+        content += "Mapped line " + std::to_string(i) + " with some words.\n";
+    }
+    create_test_file("test_mmap.txt", content);
+    
+    InputFile input;
+    assert(input.open("test_mmap.txt", InputMode::MMAP));
+    assert(input.is_mapped());
+    assert(input.view() == content);
+    input.close();
+    
+    TextProcessor buffered("./test_output");
+    TextProcessor mapped("./test_output");
+    mapped.set_input_mode(InputMode::MMAP);
+    
+    ProcessResult buffered_result = buffered.process("test_mmap.txt");
+    ProcessResult mapped_result = mapped.process("test_mmap.txt");
+    
+    assert(mapped_result.success);
+    assert(mapped_result.metadata["lines"] == buffered_result.metadata["lines"]);
+    assert(mapped_result.metadata["words"] == buffered_result.metadata["words"]);
+    assert(mapped_result.metadata["characters"] == buffered_result.metadata["characters"]);
+    
+    // Files that report size 0 (procfs) cannot be mapped and are read with pread.
+    InputFile special;
+    assert(special.open("/proc/self/status", InputMode::MMAP));
+    assert(!special.is_mapped());
+    
+    std::vector<char> buffer;
+    size_t bytes = 0;
+    assert(special.for_each_chunk(64, buffer, [&bytes](std::string_view chunk) {
+        bytes += chunk.size();
+    }));
+    assert(bytes > 0);
+    
+    std::cout << "✓ mmap and pread fallback give identical results\n";
+    
+    fs::remove("test_mmap.txt");
+    fs::remove_all("./test_output");
+}
+
+std::string read_report(const std::string& path) {
+    std::ifstream report(path);
+    return std::string((std::istreambuf_iterator<char>(report)), std::istreambuf_iterator<char>());
+}
+
+struct RecordingObserver : Observer<ProgressEvent> {
+    std::mutex mutex;
+    std::vector<ProgressEvent> events;
+    
+    void notify(const ProgressEvent& event) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(event);
+    }
+};
+
+void test_progress_throttling() {
+    std::cout << "Testing throttled progress events...\n";
+    
+    std::string content;
+    while (content.size() < (10u << 20)) {
+        content += "progress events are throttled by bytes and time\n";
+    }
+    create_test_file("test_progress.txt", content);
+    
+    ThreadPool pool(4);
+    for (size_t split_threshold : {size_t(0), size_t(1)}) {
+        TextProcessor processor("./test_output", 1024);
+        processor.enable_range_splitting(&pool, split_threshold, 1 << 20);
+        auto recorder = std::make_shared<RecordingObserver>();
+        processor.attach_progress_observer(recorder);
+        
+        ProcessResult result = pool.enqueue([&processor]() {
+            return processor.process("test_progress.txt");
+        }).get();
+        assert(result.success);
+        
+        // One event per 1 KB chunk would be over 10000.
+        const std::vector<ProgressEvent>& events = recorder->events;
+        assert(events.size() >= 2 && events.size() < 200);
+        assert(events.front().status == ProgressStatus::STARTED);
+        assert(events.back().status == ProgressStatus::COMPLETED);
+        
+        uint64_t bytes = 0;
+        for (const ProgressEvent& event : events) {
+            assert(event.file_id == events.front().file_id);
+            assert(event.total_bytes == content.size());
+            bytes += event.bytes;
+        }
+        assert(bytes == content.size());
+        
+        std::cout << "  - " << (split_threshold ? "split" : "serial") << ": " << events.size()
+                  << " events for " << content.size() << " bytes\n";
+    }
+    
+    std::cout << "✓ Progress events are throttled and add up to the file size\n";
+    
+    fs::remove("test_progress.txt");
+    fs::remove_all("./test_output");
+}
+
+// Throws from every analysis, like a processor running out of memory.
+class ThrowingProcessor : public FileProcessor<ThrowingProcessor> {
+public:
+    using FileProcessor::FileProcessor;
+    
+    ProcessResult process_impl(const std::string&) {
+        throw std::runtime_error("analysis failed");
+    }
+    
+    ProcessResult process_contents_impl(const std::string&, std::string_view) {
+        throw std::runtime_error("analysis failed");
+    }
+    
+    std::string report_path(const std::string& filepath) const {
+        return get_output_path(filepath, "_analysis");
+    }
+    
+    bool canProcess(const std::string&) const override { return true; }
+    std::string getProcessorName() const override { return "ThrowingProcessor"; }
+};
+
+void test_progress_on_exception() {
+    std::cout << "Testing progress events when a processor throws...\n";
+    
+    create_test_file("test_throwing.txt", "some text\n");
+    ThrowingProcessor processor("./test_output");
+    auto recorder = std::make_shared<RecordingObserver>();
+    processor.attach_progress_observer(recorder);
+    
+    ProcessResult from_file = processor.process("test_throwing.txt");
+    ProcessResult from_contents = processor.process_contents("test_throwing.txt", "some text\n");
+    assert(!from_file.success && !from_contents.success);
+    
+    // Each file is closed with FAILED and its bytes, so a monitor's
+    // counts still add up.
+    const std::vector<ProgressEvent>& events = recorder->events;
+    assert(events.size() == 4);
+    for (size_t i = 0; i < events.size(); i += 2) {
+        assert(events[i].status == ProgressStatus::STARTED);
+        assert(events[i + 1].status == ProgressStatus::FAILED);
+        assert(events[i + 1].file_id == events[i].file_id);
+        assert(events[i + 1].bytes == 10);
+    }
+    
+    std::cout << "✓ A throwing processor still ends its files' progress\n";
+    
+    fs::remove("test_throwing.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_range_splitting_matches_serial() {
+    std::cout << "Testing intra-file range splitting...\n";
+    
+    std::string content = "\n\nleading blank lines\n";
+    for (int i = 0; i < 400; ++i) {
+        content += "Paragraph " + std::to_string(i / 7) + " line " + std::to_string(i) + " alpha beta\n";
+        if (i % 7 == 6) {
+            content += (i % 2) ? "\n" : "\n\n\n";
+        }
+    }
+    content += "   \nno trailing newline";
+    create_test_file("test_ranges.txt", content);
+    
+    TextProcessor serial("./test_output_serial");
+    ProcessResult serial_result = serial.process("test_ranges.txt");
+    assert(serial_result.success);
+    std::string expected = read_report(serial_result.metadata["output_file"]);
+    
+    ThreadPool pool(4);
+    for (InputMode mode : {InputMode::BUFFERED, InputMode::MMAP}) {
+        for (size_t min_range : {1, 97, 1024}) {
+            TextProcessor parallel("./test_output", 64);
+            parallel.set_input_mode(mode);
+            parallel.enable_range_splitting(&pool, 1, min_range);
+            
+            ProcessResult result = pool.enqueue([&parallel]() {
+                return parallel.process("test_ranges.txt");
+            }).get();
+            
+            assert(result.success);
+            assert(result.metadata["lines"] == serial_result.metadata["lines"]);
+            assert(result.metadata["words"] == serial_result.metadata["words"]);
+            assert(result.metadata["characters"] == serial_result.metadata["characters"]);
+            assert(read_report(result.metadata["output_file"]) == expected);
+        }
+    }
+    
+    std::cout << "✓ Split analysis matches the serial report\n";
+    
+    fs::remove("test_ranges.txt");
+    fs::remove_all("./test_output");
+    fs::remove_all("./test_output_serial");
+}
+
+void test_text_kernels_agree() {
+    std::cout << "Testing SIMD text kernels against scalar...\n";
+    
+    std::mt19937 rng(42);
+    const std::string alphabet = "aZ09_- \t\n.,;\r\x80\xff\xc3\xa9@[`{/:";
+    std::string data(4096, ' ');
+    for (char& c : data) {
+        c = (rng() % 4 == 0) ? static_cast<char>(rng() % 256) : alphabet[rng() % alphabet.size()];
+    }
+    
+    TextKernel scalar = TextKernel::for_level(KernelLevel::SCALAR);
+    for (KernelLevel level : {KernelLevel::SSE2, KernelLevel::AVX2, KernelLevel::AVX512}) {
+        if (!TextKernel::supported(level)) {
+            continue;
+        }
+        
+        TextKernel kernel = TextKernel::for_level(level);
+        for (size_t offset = 0; offset + 64 <= data.size(); offset += 61) {
+            for (size_t length = 0; length <= 64; ++length) {
+                BlockClass expected = scalar.classify(data.data() + offset, length);
+                BlockClass actual = kernel.classify(data.data() + offset, length);
+                assert(actual.word_chars == expected.word_chars);
+                assert(actual.newlines == expected.newlines);
+            }
+        }
+        std::cout << "  - " << kernel.name() << " matches scalar\n";
+    }
+    
+    for (int c = 0; c < 256; ++c) {
+        char ch = static_cast<char>(c);
+        bool expected = std::isalnum(c) || ch == '_' || ch == '-';
+        assert(TextKernel::is_word_char(ch) == (c < 128 && expected));
+    }
+    
+    std::cout << "✓ All kernels classify identically (best: " << TextKernel::best().name() << ")\n";
+}
+
+void benchmark_text_kernels() {
+    std::cout << "Benchmarking text kernels on scaled sample.txt...\n";
+    
+    std::ifstream sample("data/sample.txt");
+    std::string line((std::istreambuf_iterator<char>(sample)), std::istreambuf_iterator<char>());
+    if (line.empty()) {
+        line = "The quick brown fox jumps over the lazy dog.\n";
+    }
+    
+    std::string content;
+    while (content.size() < (16u << 20)) {
+        content += line;
+    }
+    create_test_file("kernel_bench.txt", content);
+    
+    std::string expected_words;
+    for (KernelLevel level : {KernelLevel::SCALAR, KernelLevel::SSE2, KernelLevel::AVX2, KernelLevel::AVX512}) {
+        if (!TextKernel::supported(level)) {
+            continue;
+        }
+        
+        TextProcessor processor("./test_output", 1 << 16);
+        processor.set_input_mode(InputMode::MMAP);
+        processor.set_text_kernel(level);
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        ProcessResult result = processor.process("kernel_bench.txt");
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        
+        assert(result.success);
+        if (expected_words.empty()) {
+            expected_words = result.metadata["words"];
+        }
+        assert(result.metadata["words"] == expected_words);
+        
+        std::cout << "  - " << TextKernel::for_level(level).name() << ": "
+                  << (content.size() / 1024.0 / 1024.0) / seconds << " MB/s\n";
+    }
+    
+    std::cout << "✓ Kernel benchmark completed\n";
+    
+    fs::remove("kernel_bench.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_word_counter_allocations() {
+    std::cout << "Testing allocation-free word counting...\n";
+    
+    const std::vector<std::string> vocabulary = {
+        "The", "quick", "BROWN", "fox", "jumps", "over", "lazy", "dog",
+        "a_rather_long_identifier_name", "x-ray", "42", "Lorem", "ipsum"
+    };
+    
+    WordCounter counter;
+    for (const auto& word : vocabulary) {
+        counter.add(word);
+    }
+    assert(counter.count("the") == 1);
+    assert(counter.count("brown") == 1);
+    
+    size_t expected_the = 1;
+    size_t before = g_allocations.load();
+    for (int i = 0; i < 100000; ++i) {
+        std::string_view word = (i % 2) ? std::string_view(vocabulary[i % vocabulary.size()]) : "THE";
+        counter.add(word);
+        expected_the += (word == "THE" || word == "The") ? 1 : 0;
+    }
+    size_t allocations = g_allocations.load() - before;
+    
+    assert(allocations == 0);
+    assert(counter.size() == vocabulary.size());
+    assert(counter.count("tHe") == expected_the);
+    
+    // Whole-file analysis: allocations must not grow with the word count.
+    std::string small_text;
+    std::string large_text;
+    for (int i = 0; i < 100; ++i) {
+        small_text += vocabulary[i % vocabulary.size()] + " ";
+    }
+    for (int i = 0; i < 100000; ++i) {
+        large_text += vocabulary[i % vocabulary.size()] + ((i % 10 == 9) ? "\n" : " ");
+    }
+    create_test_file("alloc_small.txt", small_text);
+    create_test_file("alloc_large.txt", large_text);
+    
+    TextProcessor processor("./test_output", 1 << 24);
+    processor.set_input_mode(InputMode::MMAP);
+    processor.process("alloc_small.txt");
+    
+    before = g_allocations.load();
+    processor.process("alloc_small.txt");
+    size_t small_allocations = g_allocations.load() - before;
+    
+    before = g_allocations.load();
+    processor.process("alloc_large.txt");
+    size_t large_allocations = g_allocations.load() - before;
+    
+    std::cout << "  - 100 words: " << small_allocations << " allocations, 100000 words: "
+              << large_allocations << " allocations\n";
+    assert(large_allocations == small_allocations);
+    
+    std::cout << "✓ Steady-state word counting performs no heap allocations\n";
+    
+    fs::remove("alloc_small.txt");
+    fs::remove("alloc_large.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_word_counter_reuse_after_large_file() {
+    std::cout << "Testing small files after a large vocabulary...\n";
+    
+    // Three words, counted, ranked and cleared as a processor does per file.
+    auto small_files = [](WordCounter& counter, int files) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < files; ++i) {
+            counter.add("alpha");
+            counter.add("beta");
+            counter.add("gamma");
+            assert(counter.top(10).size() == 3);
+            counter.clear();
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+    
+    WordCounter fresh;
+    WordCounter reused;
+    for (int i = 0; i < 40000; ++i) {
+        reused.add("word" + std::to_string(i));
+    }
+    reused.clear();
+    assert(reused.empty() && reused.count("word7") == 0);
+    
+    const int files = 20000;
+    double fresh_micros = small_files(fresh, files);
+    double reused_micros = small_files(reused, files);
+    std::cout << "  - " << files << " three-word files: " << fresh_micros / files << " us each on a fresh table, "
+              << reused_micros / files << " us after 40000 distinct words\n";
+    
+    // Clearing or walking the whole retained table would cost ~100x.
+    assert(reused_micros < fresh_micros * 4 + 20000);
+    
+    std::cout << "✓ A large file leaves no per-file cost behind\n";
+}
+
+void test_top_k_and_heavy_hitters() {
+    std::cout << "Testing top-k selection and heavy hitters...\n";
+    
+    // Zipf-like stream over 5000 distinct words.
+    std::mt19937 rng(7);
+    std::vector<std::string> stream;
+    for (int i = 0; i < 200000; ++i) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        stream.push_back("w" + std::to_string(static_cast<int>(std::pow(5000.0, u)) - 1));
+    }
+    
+    WordCounter exact;
+    for (const auto& word : stream) {
+        exact.add(word);
+    }
+    
+    std::vector<std::pair<std::string_view, size_t>> sorted;
+    exact.for_each([&sorted](std::string_view word, size_t count) {
+        sorted.emplace_back(word, count);
+    });
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    
+    auto top = exact.top(10);
+    assert(top.size() == 10);
+    for (size_t i = 0; i < top.size(); ++i) {
+        assert(top[i] == sorted[i]);
+    }
+    assert(exact.top(0).empty());
+    assert(exact.top(sorted.size() + 5).size() == sorted.size());
+    
+    // Space-Saving: counts never undercount, overcount by at most the
+    // entry's error, and the error is bounded by total / capacity.
+    auto check_summary = [&exact](const HeavyHitters& summary) {
+        assert(summary.size() <= summary.capacity());
+        assert(summary.error_bound() <= summary.total() / summary.capacity());
+        for (const auto& entry : summary.top(summary.capacity())) {
+            size_t truth = exact.count(entry.word);
+            assert(entry.count >= truth);
+            assert(entry.count - entry.error <= truth);
+            assert(entry.error <= summary.error_bound());
+        }
+    };
+    
+    HeavyHitters whole(256);
+    for (const auto& word : stream) {
+        whole.add(word);
+    }
+    assert(whole.total() == stream.size());
+    check_summary(whole);
+    
+    // Merged halves keep the same guarantees for the full stream.
+    HeavyHitters first(256);
+    HeavyHitters second(256);
+    for (size_t i = 0; i < stream.size(); ++i) {
+        (i < stream.size() / 2 ? first : second).add(stream[i]);
+    }
+    first.merge(second);
+    assert(first.total() == stream.size());
+    check_summary(first);
+    
+    // The head of a skewed distribution is recovered exactly in order.
+    auto approximate = whole.top(5);
+    for (size_t i = 0; i < approximate.size(); ++i) {
+        assert(approximate[i].word == sorted[i].first);
+    }
+    
+    // Case folding matches WordCounter.
+    HeavyHitters folded(4);
+    folded.add("The");
+    folded.add("THE");
+    assert(folded.top(1)[0].word == "the" && folded.top(1)[0].count == 2);
+    
+    std::string text;
+    for (size_t i = 0; i < 20000; ++i) {
+        text += stream[i] + ((i % 12 == 11) ? "\n" : " ");
+    }
+    create_test_file("heavy_test.txt", text);
+    
+    TextProcessor processor("./test_output");
+    processor.set_heavy_hitters_memory(64 * 1024);
+    ProcessResult result = processor.process("heavy_test.txt");
+    assert(result.success);
+    assert(result.metadata["words"] == "20000");
+    
+    std::string report = read_report(result.metadata["output_file"]);
+    assert(report.find("approximate") != std::string::npos);
+    assert(report.find("Counts exceed true counts by at most") != std::string::npos);
+    
+    std::cout << "✓ Top-k matches a full sort and heavy-hitter bounds hold\n";
+    
+    fs::remove("heavy_test.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_corpus_counter() {
+    std::cout << "Testing corpus-wide word counts...\n";
+    
+    // 64 "files" drawn from one Zipf-like vocabulary, so most words occur
+    // in many files and have to be combined.
+    std::mt19937 rng(11);
+    std::vector<WordCounter> files(64);
+    WordCounter expected;
+    for (auto& file : files) {
+        for (int i = 0; i < 5000; ++i) {
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            std::string word = "w" + std::to_string(static_cast<int>(std::pow(20000.0, u)) - 1);
+            file.add(word);
+            expected.add(word);
+        }
+    }
+    
+    CorpusCounter corpus;
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < 8; ++t) {
+        workers.emplace_back([&corpus, &files, t]() {
+            for (size_t i = t; i < files.size(); i += 8) {
+                corpus.add(files[i]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    assert(corpus.files() == files.size());
+    assert(corpus.total_words() == files.size() * 5000);
+    assert(corpus.distinct_words() == expected.size());
+    
+    // Every shard's words are disjoint, so combining shard top lists gives
+    // exactly the global order, ties included.
+    auto top = corpus.top(expected.size());
+    auto reference = expected.top(expected.size());
+    assert(top.size() == reference.size());
+    for (size_t i = 0; i < top.size(); ++i) {
+        assert(top[i].word == reference[i].first && top[i].count == reference[i].second);
+    }
+    assert(corpus.top(0).empty());
+    assert(corpus.top(5).size() == 5 && corpus.top(5)[4].word == reference[4].first);
+    
+    // Processors sharing a counter add each analyzed file once; files
+    // summarized by heavy hitters are left out.
+    create_test_file("corpus_a.txt", "The cat sat.\nThe end.\n");
+    create_test_file("corpus_b.txt", "the CAT and the dog\n");
+    
+    CorpusCounter shared;
+    TextProcessor first("./test_output");
+    TextProcessor second("./test_output");
+    TextProcessor approximate("./test_output");
+    first.set_corpus_counter(&shared);
+    second.set_corpus_counter(&shared);
+    approximate.set_corpus_counter(&shared);
+    approximate.set_heavy_hitters_memory(64 * 1024);
+    assert(first.process("corpus_a.txt").success);
+    assert(second.process("corpus_b.txt").success);
+    assert(approximate.process("corpus_b.txt").success);
+    
+    assert(shared.files() == 2);
+    assert(shared.total_words() == 10);
+    assert(shared.distinct_words() == 6);
+    auto words = shared.top(2);
+    assert(words[0].word == "the" && words[0].count == 4);
+    assert(words[1].word == "cat" && words[1].count == 2);
+    
+    std::string report = shared.format_report(3);
+    assert(report.find("Files: 2") != std::string::npos);
+    assert(report.find("Distinct words: 6") != std::string::npos);
+    assert(report.find("1. the (4 times)") != std::string::npos);
+    assert(report.find("3. and (1 times)") != std::string::npos);
+    
+    std::cout << "✓ Sharded corpus counts match a serial merge\n";
+    
+    fs::remove("corpus_a.txt");
+    fs::remove("corpus_b.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_processor_pool_reuse() {
+    std::cout << "Testing processor reuse across files...\n";
+    
+    std::vector<std::string> files;
+    for (int i = 0; i < 200; ++i) {
+        std::string name = "reuse_" + std::to_string(i) + ".txt";
+        create_test_file(name, "word" + std::to_string(i) + " shared Shared\n");
+        files.push_back(name);
+    }
+    
+    ProcessorPool processors([]() -> std::unique_ptr<IFileProcessor> {
+        return std::make_unique<TextProcessor>("./test_output");
+    });
+    
+    {
+        ThreadPool pool(4);
+        std::vector<std::future<ProcessResult>> futures;
+        for (const auto& file : files) {
+            futures.push_back(pool.enqueue([&processors, file]() {
+                auto processor = processors.acquire();
+                return processor->process(file);
+            }));
+        }
+        
+        for (size_t i = 0; i < futures.size(); ++i) {
+            ProcessResult result = futures[i].get();
+            assert(result.success);
+            assert(result.metadata["words"] == "3");
+            
+            // A reused processor must not carry words from earlier files.
+            std::string report = read_report(result.metadata["output_file"]);
+            assert(report.find("1. shared (2 times)") != std::string::npos);
+            assert(report.find("2. word" + std::to_string(i) + " (1 times)") != std::string::npos);
+            assert(report.find("3.") == std::string::npos);
+        }
+    }
+    
+    assert(processors.created() <= 4);
+    std::cout << "  - 200 files with " << processors.created() << " processors\n";
+    
+    // The output directory is cached but recreated if it goes away.
+    fs::remove_all("./test_output");
+    ProcessResult result = processors.acquire()->process(files[0]);
+    assert(result.success);
+    assert(fs::exists(result.metadata["output_file"]));
+    
+    std::cout << "✓ Processors are reused without leaking state between files\n";
+    
+    for (const auto& file : files) {
+        fs::remove(file);
+    }
+    fs::remove_all("./test_output");
+}
+
+void test_directory_walker() {
+    std::cout << "Testing parallel directory walker...\n";
+    
+    fs::remove_all("walk_test");
+    std::map<std::string, size_t> expected;
+    for (int d = 0; d < 6; ++d) {
+        std::string dir = "walk_test/d" + std::to_string(d) + "/nested" + std::to_string(d % 2);
+        fs::create_directories(dir);
+        for (int f = 0; f < 25; ++f) {
+            std::string path = dir + "/f" + std::to_string(f) + ".txt";
+            std::string content(static_cast<size_t>(d * 100 + f), 'x');
+            create_test_file(path, content);
+            expected[path] = content.size();
+        }
+    }
+    create_test_file("walk_test/top.txt", "top level\n");
+    expected["walk_test/top.txt"] = 10;
+    
+    // Extra names for files already listed must not be reported again.
+    fs::create_hard_link("walk_test/top.txt", "walk_test/d0/top_link.txt");
+    fs::create_symlink("../top.txt", "walk_test/d1/top_symlink.txt");
+    fs::create_directory_symlink("../d0", "walk_test/d2/d0_symlink");
+    
+    std::map<std::string, size_t> found;
+    size_t duplicates = 0;
+    {
+        ThreadPool pool(4);
+        DirectoryWalker walker(pool);
+        walker.start("walk_test");
+        
+        DirectoryWalker::Entry entry;
+        while (walker.next(entry)) {
+            found[entry.path] = entry.size;
+        }
+        assert(walker.files_found() == found.size());
+        duplicates = walker.duplicates_skipped();
+    }
+    
+    // Either name of the hard-linked file may win the race.
+    if (found.count("walk_test/top.txt") == 0) {
+        assert(found.count("walk_test/d0/top_link.txt") || found.count("walk_test/d1/top_symlink.txt"));
+        found.erase("walk_test/d0/top_link.txt");
+        found.erase("walk_test/d1/top_symlink.txt");
+        found["walk_test/top.txt"] = 10;
+    }
+    assert(found == expected);
+    assert(duplicates == 2);
+    
+    // A full queue parks the directory tasks instead of blocking the only
+    // worker, which the consumer needs for its own tasks.
+    {
+        ThreadPool pool(1);
+        DirectoryWalker walker(pool, 4);
+        walker.start("walk_test");
+        
+        size_t files = 0;
+        DirectoryWalker::Entry entry;
+        while (walker.next(entry)) {
+            pool.enqueue([]() {}).get();
+            ++files;
+        }
+        assert(files == expected.size());
+    }
+    
+    // Parked directories are abandoned when the walk is not drained.
+    {
+        ThreadPool pool(2);
+        DirectoryWalker walker(pool, 2);
+        walker.start("walk_test");
+        DirectoryWalker::Entry entry;
+        assert(walker.next(entry));
+    }
+    
+    {
+        ThreadPool pool(2);
+        DirectoryWalker walker(pool);
+        walker.start("walk_test/top.txt");
+        DirectoryWalker::Entry entry;
+        assert(walker.next(entry) && entry.path == "walk_test/top.txt" && entry.size == 10);
+        assert(!walker.next(entry));
+    }
+    
+    std::vector<DirectoryWalker::Entry> entries = {{"a", 5}, {"b", 50}, {"c", 5}, {"d", 1}};
+    DirectoryWalker::order_for_schedule(entries, SchedulePolicy::LARGEST_FIRST);
+    assert(entries[0].path == "b" && entries[1].path == "a" && entries[2].path == "c" && entries[3].path == "d");
+    DirectoryWalker::order_for_schedule(entries, SchedulePolicy::SMALLEST_FIRST);
+    assert(entries[0].path == "d" && entries[1].path == "a" && entries[2].path == "c" && entries[3].path == "b");
+    DirectoryWalker::order_for_schedule(entries, SchedulePolicy::SUBMISSION);
+    assert(entries[0].path == "d" && entries[3].path == "b");
+    
+    ProcessingStats stats;
+    stats.record_task(std::chrono::microseconds(4000000));
+    stats.record_task(std::chrono::microseconds(1000000));
+    stats.record_task(std::chrono::microseconds(1000000));
+    assert(stats.get_ideal_makespan_seconds(1) == 6.0);
+    assert(stats.get_ideal_makespan_seconds(2) == 4.0);
+    assert(stats.get_ideal_makespan_seconds(8) == 4.0);
+    
+    std::cout << "✓ Walker finds every file once with its size\n";
+    
+    fs::remove_all("walk_test");
+}
+
+void test_file_batcher() {
+    std::cout << "Testing small-file batching...\n";
+    
+    std::vector<std::vector<std::string>> sent;
+    std::vector<size_t> sent_bytes;
+    FileBatcher batcher(100, 3, [&sent, &sent_bytes](std::vector<std::string> files, size_t bytes) {
+        sent.push_back(std::move(files));
+        sent_bytes.push_back(bytes);
+    });
+    
+    batcher.add("a", 40);
+    batcher.add("b", 40);
+    batcher.add("big", 100);
+    batcher.add("c", 30);
+    batcher.add("d", 10);
+    batcher.add("e", 10);
+    batcher.add("f", 10);
+    batcher.flush();
+    batcher.flush();
+    
+    // "big" reaches the byte budget and goes alone; "c" would exceed it;
+    // "f" would exceed the count budget.
+    assert(sent.size() == 4);
+    assert((sent[0] == std::vector<std::string>{"big"}));
+    assert((sent[1] == std::vector<std::string>{"a", "b"}));
+    assert((sent[2] == std::vector<std::string>{"c", "d", "e"}));
+    assert((sent[3] == std::vector<std::string>{"f"}));
+    assert((sent_bytes == std::vector<size_t>{100, 80, 50, 10}));
+    assert(batcher.batches_sent() == 4);
+    
+    sent.clear();
+    FileBatcher unbatched(0, 64, [&sent](std::vector<std::string> files, size_t) {
+        sent.push_back(std::move(files));
+    });
+    unbatched.add("x", 1);
+    unbatched.add("y", 1);
+    unbatched.flush();
+    assert(sent.size() == 2 && sent[0].size() == 1 && sent[1].size() == 1);
+    assert(unbatched.batches_sent() == 2);
+    
+    std::cout << "✓ Small files are grouped within the byte and count budgets\n";
+}
+
+void test_manifest() {
+    std::cout << "Testing incremental manifest...\n";
+    
+    // Reference XXH64 digests, and the same digest for any split.
+    assert(ContentHasher::hash("") == 0xEF46DB3751D8E999ULL);
+    assert(ContentHasher::hash("abc") == 0x44BC2CF5AD770999ULL);
+    std::string text(1000, ' ');
+    for (size_t i = 0; i < text.size(); ++i) {
+        text[i] = static_cast<char>('a' + i * 7 % 26);
+    }
+    ContentHasher pieces;
+    for (size_t i = 0; i < text.size(); i += 13) {
+        pieces.update(std::string_view(text).substr(i, 13));
+    }
+    assert(pieces.digest() == ContentHasher::hash(text));
+    
+    fs::create_directories("./test_output");
+    create_test_file("test_manifest.txt", "manifest\tcontents\n");
+    create_test_file("./test_output/test_manifest_analysis.txt", "report\n");
+    
+    Manifest::FileState state;
+    state.size = 18;
+    state.mtime_ns = 1000;
+    state.device = 1;
+    state.inode = 42;
+    
+    ProcessResult result;
+    result.success = true;
+    result.input_path = "test_manifest.txt";
+    result.message = "done\twith\\tabs\n";
+    result.bytes_processed = 18;
+    result.metadata["words"] = "2";
+    result.metadata["output_file"] = "./test_output/test_manifest_analysis.txt";
+    result.metadata["content_hash"] = std::to_string(ContentHasher::hash("manifest\tcontents\n"));
+    
+    ProcessResult previous;
+    {
+        Manifest manifest("./test_output/manifest", "settings", true);
+        assert(!manifest.load());
+        assert(!manifest.reuse("test_manifest.txt", state, previous));
+        assert(!manifest.reuse("gone.txt", state, previous));
+        manifest.record(result);
+        assert(manifest.save());
+    }
+    
+    {
+        Manifest manifest("./test_output/manifest", "settings", true);
+        assert(manifest.load());
+        assert(manifest.reuse("test_manifest.txt", state, previous));
+        assert(previous.success && previous.message == result.message);
+        assert(previous.metadata == result.metadata);
+        
+        // A new inode and mtime with the same contents still matches by hash.
+        Manifest::FileState copied = state;
+        copied.inode = 43;
+        copied.mtime_ns = 2000;
+        assert(manifest.reuse("test_manifest.txt", copied, previous));
+        assert(manifest.save());
+    }
+    
+    {
+        Manifest manifest("./test_output/manifest", "settings", false);
+        assert(manifest.load());
+        Manifest::FileState touched = state;
+        touched.inode = 43;
+        touched.mtime_ns = 3000;
+        assert(!manifest.reuse("test_manifest.txt", touched, previous));
+    }
+    
+    // Other settings or a deleted report mean processing again.
+    {
+        Manifest manifest("./test_output/manifest", "other settings", true);
+        assert(!manifest.load());
+        assert(manifest.size() == 0);
+    }
+    {
+        Manifest manifest("./test_output/manifest", "settings", false);
+        assert(manifest.load());
+        fs::remove("./test_output/test_manifest_analysis.txt");
+        Manifest::FileState copied = state;
+        copied.inode = 43;
+        copied.mtime_ns = 2000;
+        assert(!manifest.reuse("test_manifest.txt", copied, previous));
+    }
+    
+    // Workers hash exactly the bytes they analyze, however they read them.
+    {
+        std::string contents;
+        for (int i = 0; i < 5000; ++i) {
+            contents += "hashed line " + std::to_string(i) + "\n";
+        }
+        create_test_file("test_manifest.txt", contents);
+        std::string expected = std::to_string(ContentHasher::hash(contents));
+        
+        TextProcessor processor("./test_output", 1000);
+        processor.set_content_hashing(true);
+        assert(processor.process("test_manifest.txt").metadata["content_hash"] == expected);
+        assert(processor.process_contents("test_manifest.txt", contents).metadata["content_hash"] == expected);
+        
+        ThreadPool pool(2);
+        processor.enable_range_splitting(&pool, 1, 4096);
+        assert(processor.process("test_manifest.txt").metadata["content_hash"] == expected);
+        
+        processor.set_content_hashing(false);
+        assert(processor.process("test_manifest.txt").metadata.count("content_hash") == 0);
+    }
+    
+    std::cout << "✓ Manifest skips unchanged files and round-trips results\n";
+    
+    fs::remove("test_manifest.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_deduplicator() {
+    std::cout << "Testing content deduplication...\n";
+    
+    std::string shared;
+    for (int i = 0; i < 2000; ++i) {
+        shared += "identical line " + std::to_string(i % 37) + "\n";
+    }
+    fs::create_directories("./test_dedup");
+    for (int i = 0; i < 6; ++i) {
+        create_test_file("./test_dedup/copy" + std::to_string(i) + ".txt", shared);
+    }
+    create_test_file("./test_dedup/other.txt", shared + "one more line\n");
+    
+    ThreadPool pool(4);
+    ProcessorPool processors([]() { return std::make_unique<TextProcessor>("./test_output", 256); });
+    Deduplicator deduplicator(pool, 0);
+    
+    std::vector<std::future<ProcessResult>> futures;
+    for (int i = 0; i < 6; ++i) {
+        std::string path = "./test_dedup/copy" + std::to_string(i) + ".txt";
+        futures.push_back(pool.enqueue([&processors, &deduplicator, path, i]() {
+            auto processor = processors.acquire();
+            // Half the copies come through the in-memory path.
+            if (i % 2) {
+                std::string contents = read_report(path);
+                return deduplicator.process_contents(*processor, path, contents);
+            }
+            return deduplicator.process(*processor, path);
+        }));
+    }
+    futures.push_back(pool.enqueue([&processors, &deduplicator]() {
+        auto processor = processors.acquire();
+        return deduplicator.process(*processor, "./test_dedup/other.txt");
+    }));
+    
+    std::vector<ProcessResult> results;
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+    
+    assert(deduplicator.duplicates() == 5);
+    assert(deduplicator.bytes_saved() == 5 * shared.size());
+    
+    TextProcessor serial("./test_output_serial");
+    std::string expected = read_report(serial.process("./test_dedup/copy0.txt").metadata["output_file"]);
+    size_t shared_results = 0;
+    for (int i = 0; i < 6; ++i) {
+        ProcessResult& result = results[i];
+        assert(result.success);
+        assert(result.input_path == "./test_dedup/copy" + std::to_string(i) + ".txt");
+        assert(result.metadata["output_file"] == "./test_output/copy" + std::to_string(i) + "_analysis.txt");
+        assert(read_report(result.metadata["output_file"]) == expected);
+        shared_results += result.metadata.count("duplicate_of");
+    }
+    assert(shared_results == 5);
+    assert(results[6].success && results[6].metadata.count("duplicate_of") == 0);
+    assert(read_report(results[6].metadata["output_file"]) != expected);
+    
+    std::cout << "✓ Identical files are analyzed once and share the report\n";
+    
+    fs::remove_all("./test_dedup");
+    fs::remove_all("./test_output");
+    fs::remove_all("./test_output_serial");
+}
+
+void test_directory_watcher() {
+    std::cout << "Testing directory watcher...\n";
+    
+    fs::remove_all("watch_test");
+    fs::create_directories("watch_test/in/sub");
+    fs::create_directories("watch_test/in/out");
+    create_test_file("watch_test/in/existing.txt", "already here\n");
+    
+    DirectoryWatcher watcher(std::chrono::milliseconds(30));
+    watcher.ignore("watch_test/in/out");
+    assert(watcher.watch("watch_test/in"));
+    assert(watcher.directories() == 2);
+    
+    // Files present before watching are not reported; nothing happens.
+    std::vector<std::string> changed;
+    assert(watcher.wait(changed, std::chrono::milliseconds(50)));
+    assert(changed.empty());
+    
+    // Several writes to one file are reported once, after they settle,
+    // and nothing is reported for the ignored directory.
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5; ++i) {
+        std::ofstream file("watch_test/in/sub/written.txt", std::ios::app);
+        file << "line " << i << "\n";
+    }
+    create_test_file("watch_test/in/out/report.txt", "ignored\n");
+    while (changed.empty()) {
+        assert(watcher.wait(changed, std::chrono::seconds(1)));
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    }
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(30));
+    assert((changed == std::vector<std::string>{"watch_test/in/sub/written.txt"}));
+    
+    // A new directory is watched along with what was already put in it;
+    // a file renamed into the tree counts, one deleted before it settled
+    // does not.
+    changed.clear();
+    fs::create_directories("watch_test/in/new/deep");
+    create_test_file("watch_test/in/new/deep/a.txt", "a\n");
+    create_test_file("watch_test/outside.txt", "moved in\n");
+    fs::rename("watch_test/outside.txt", "watch_test/in/moved.txt");
+    create_test_file("watch_test/in/short_lived.txt", "gone\n");
+    fs::remove("watch_test/in/short_lived.txt");
+    start = std::chrono::steady_clock::now();
+    while (changed.size() < 2 && std::chrono::steady_clock::now() - start < std::chrono::seconds(1)) {
+        assert(watcher.wait(changed, std::chrono::milliseconds(100)));
+    }
+    assert(watcher.wait(changed, std::chrono::milliseconds(50)));
+    std::sort(changed.begin(), changed.end());
+    assert((changed == std::vector<std::string>{"watch_test/in/moved.txt", "watch_test/in/new/deep/a.txt"}));
+    assert(watcher.directories() == 4);
+    
+    // stop() ends a wait from another thread.
+    changed.clear();
+    std::thread stopper([&watcher]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        watcher.stop();
+    });
+    assert(!watcher.wait(changed));
+    stopper.join();
+    assert(!watcher.wait(changed, std::chrono::milliseconds(0)));
+    
+    std::cout << "✓ Watcher reports settled writes, new directories and moves\n";
+    
+    fs::remove_all("watch_test");
+}
+
+void test_report_writer() {
+    std::cout << "Testing report writer...\n";
+    
+    std::string text;
+    for (int i = 0; i < 300; ++i) {
+        text += "quoted \"word\" line " + std::to_string(i % 7) + "\n";
+    }
+    create_test_file("test_report_writer.txt", text);
+    
+    TextProcessor direct("./test_output_direct");
+    std::string expected = read_report(direct.process("test_report_writer.txt").metadata["output_file"]);
+    
+    // Reports handed to the writer match the ones written directly, and a
+    // copy queued behind its original sees it.
+    {
+        ReportWriter writer(8);
+        TextProcessor processor("./test_output");
+        processor.set_report_writer(&writer);
+        
+        ProcessResult result;
+        for (int i = 0; i < 50; ++i) {
+            result = processor.process("test_report_writer.txt");
+            assert(result.success);
+        }
+        ProcessResult copy = processor.share_result("./elsewhere/copy.txt", result);
+        writer.flush();
+        
+        assert(writer.reports_written() == 51 && writer.write_errors() == 0);
+        assert(read_report(result.metadata["output_file"]) == expected);
+        assert(copy.metadata["output_file"] == "./test_output/copy_analysis.txt");
+        assert(read_report(copy.metadata["output_file"]) == expected);
+        
+        writer.write("/proc/version/impossible", "x");
+        writer.flush();
+        assert(writer.write_errors() == 1);
+    }
+    
+    // The consolidated stream gets one JSON line per file.
+    {
+        ReportWriter writer;
+        assert(writer.open_stream("./test_output/reports.ndjson", false));
+        TextProcessor processor("./test_output", 64);
+        processor.set_report_writer(&writer);
+        
+        ProcessResult result = processor.process("test_report_writer.txt");
+        assert(result.metadata["output_file"] == "./test_output/reports.ndjson");
+        processor.share_result("copy\tof.txt", result);
+        writer.flush();
+        
+        std::string stream = read_report("./test_output/reports.ndjson");
+        std::string first = stream.substr(0, stream.find('\n') + 1);
+        assert(first.rfind("{\"file\":\"test_report_writer.txt\",\"lines\":300,\"words\":1200,", 0) == 0);
+        assert(first.find("{\"word\":\"word\",\"count\":300}") != std::string::npos);
+        assert(stream.substr(first.size()) ==
+               "{\"file\":\"copy\\u0009of.txt\",\"duplicate_of\":\"test_report_writer.txt\"}\n");
+    }
+    
+    // Reopening rewrites the stream; only records carried over survive,
+    // each at most once, and the set-aside stream goes away afterwards.
+    {
+        std::string previous = read_report("./test_output/reports.ndjson");
+        std::string copy_record = previous.substr(previous.find('\n') + 1);
+        
+        ReportWriter writer;
+        assert(writer.open_stream("./test_output/reports.ndjson", true));
+        assert(fs::exists("./test_output/reports.ndjson.prev"));
+        assert(writer.carry_over("copy\tof.txt"));
+        assert(!writer.carry_over("copy\tof.txt"));
+        assert(!writer.carry_over("missing.txt"));
+        writer.flush();
+        writer.drop_previous();
+        
+        assert(read_report("./test_output/reports.ndjson") == copy_record);
+        assert(!fs::exists("./test_output/reports.ndjson.prev"));
+    }
+    
+    std::string number;
+    append_decimal(number, 0);
+    append_decimal(number, 18446744073709551615ULL);
+    assert(number == "018446744073709551615");
+    
+    std::cout << "✓ Reports written from the writer thread match direct writes\n";
+    
+    fs::remove("test_report_writer.txt");
+    fs::remove_all("./test_output");
+    fs::remove_all("./test_output_direct");
+}
+
+void test_results_store() {
+    std::cout << "Testing binary results store...\n";
+    
+    fs::create_directories("./test_output");
+    create_test_file("test_results.txt", "beta alpha beta\n\ngamma beta alpha\n");
+    TextProcessor processor("./test_output");
+    ProcessResult analyzed = processor.process("test_results.txt");
+    assert(analyzed.metadata["paragraphs"] == "2");
+    assert(analyzed.metadata["top_words"] == "beta 3 alpha 2 gamma 1");
+    
+    ProcessResult empty;
+    empty.success = true;
+    empty.input_path = "empty.txt";
+    
+    ProcessResult failed;
+    failed.input_path = "failed.txt";
+    
+    ProcessResult stale = analyzed;
+    stale.metadata["lines"] = "99";
+    
+    ResultsStore store("./test_output/results.fpr");
+    store.add(stale);
+    store.add(empty);
+    store.add(failed);
+    store.add(analyzed);
+    assert(store.size() == 2);
+    assert(store.save());
+    
+    ResultsReader reader;
+    assert(reader.open("./test_output/results.fpr"));
+    assert(reader.version() == kResultsVersion);
+    assert(reader.size() == 2);
+    assert(reader.path(0) == "test_results.txt" && reader.path(1) == "empty.txt");
+    assert(reader.lines(0) == 3 && reader.words(0) == 6 && reader.paragraphs(0) == 2);
+    assert(reader.characters(0) == 34 && reader.bytes(0) == 34);
+    assert(reader.top_word_count(0) == 3 && reader.top_word_count(1) == 0);
+    assert(reader.top_word(0, 0).word == "beta" && reader.top_word(0, 0).count == 3);
+    assert(reader.top_word(0, 2).word == "gamma" && reader.top_word(0, 2).count == 1);
+    
+    std::span<const uint64_t> words = reader.column(ResultsColumn::WORDS);
+    assert(words.size() == 2 && words[0] == 6 && words[1] == 0);
+    assert(reader.column(ResultsColumn::STRINGS).empty());
+    
+    // Damaged or foreign files are rejected instead of read out of bounds.
+    std::string image = read_report("./test_output/results.fpr");
+    create_test_file("./test_output/truncated.fpr", image.substr(0, image.size() - 8));
+    assert(!reader.open("./test_output/truncated.fpr") && reader.size() == 0);
+    
+    std::string future = image;
+    future[8] = 2;
+    create_test_file("./test_output/future.fpr", future);
+    assert(!reader.open("./test_output/future.fpr"));
+    assert(reader.error() == "unsupported version 2");
+    
+    std::string bad_offset = image;
+    ResultsHeader header;
+    std::memcpy(&header, bad_offset.data(), sizeof(header));
+    ResultsColumnEntry entry;
+    std::memcpy(&entry, bad_offset.data() + header.columns_offset, sizeof(entry));
+    uint64_t huge = uint64_t(1) << 40;
+    std::memcpy(bad_offset.data() + entry.offset, &huge, sizeof(huge));
+    create_test_file("./test_output/bad_offset.fpr", bad_offset);
+    assert(!reader.open("./test_output/bad_offset.fpr"));
+    
+    assert(!reader.open("test_results.txt"));
+    assert(reader.open("./test_output/results.fpr") && reader.size() == 2);
+    
+    std::cout << "✓ Results file round-trips metrics and rejects damaged files\n";
+    
+    fs::remove("test_results.txt");
+    fs::remove_all("./test_output");
+}
+
+void test_read_engine() {
+    std::cout << "Testing async read engines...\n";
+    
+    std::mt19937 rng(11);
+    std::vector<std::pair<std::string, std::string>> files;
+    for (size_t size : {size_t(0), size_t(1), size_t(4096), size_t(100000), size_t(3 << 20)}) {
+        std::string content(size, ' ');
+        for (char& c : content) {
+            c = "abc \n"[rng() % 5];
+        }
+        std::string name = "engine_" + std::to_string(size) + ".txt";
+        create_test_file(name, content);
+        files.emplace_back(name, content);
+    }
+    
+    for (bool allow_uring : {true, false}) {
+        auto engine = ReadEngine::create(2, 1 << 20, allow_uring);
+        std::cout << "  - " << engine->name() << " engine\n";
+        
+        std::vector<std::future<ReadBuffer>> reads;
+        for (const auto& [name, content] : files) {
+            reads.push_back(engine->read(name));
+        }
+        for (size_t i = 0; i < reads.size(); ++i) {
+            ReadBuffer buffer = reads[i].get();
+            assert(buffer.error() == 0);
+            assert(buffer.view() == files[i].second);
+        }
+        assert(engine->buffered_bytes() == 0);
+        
+        ReadBuffer missing = engine->read("engine_missing.txt").get();
+        assert(missing.error() == ENOENT);
+        
+        // Held buffers count against the budget until released.
+        {
+            ReadBuffer held = engine->read(files[3].first).get();
+            assert(engine->buffered_bytes() == files[3].second.size());
+        }
+        assert(engine->buffered_bytes() == 0);
+        engine->wait_for_buffer_space(10 << 20);
+        
+        // Analysis of read-ahead contents matches reading the file.
+        TextProcessor processor("./test_output");
+        ProcessResult from_file = processor.process(files[4].first);
+        std::string expected = read_report(from_file.metadata["output_file"]);
+        ReadBuffer buffer = engine->read(files[4].first).get();
+        ProcessResult from_buffer = processor.process_contents(files[4].first, buffer.view());
+        assert(from_buffer.success);
+        assert(from_buffer.bytes_processed == files[4].second.size());
+        assert(read_report(from_buffer.metadata["output_file"]) == expected);
+    }
+    
+    std::cout << "✓ Read engines return whole files and respect the buffer budget\n";
+    
+    for (const auto& file : files) {
+        fs::remove(file.first);
+    }
+    fs::remove_all("./test_output");
+}
+
 void test_file_extension_support() {
     std::cout << "Testing file extension support...\n";
     
@@ -219,21 +1509,107 @@ void benchmark_text_processing() {
     fs::remove_all("./test_output");
 }
 
+// Corpus totals from 64 workers: the sharded table is complete when the
+// last file is added, while per-worker tables still have to be combined,
+// serially or as a tree, once the run ends.
+void benchmark_corpus_counter() {
+    std::cout << "Benchmarking corpus word aggregation...\n";
+    
+    constexpr size_t kWorkers = 64;
+    std::mt19937 rng(3);
+    std::vector<WordCounter> files(kWorkers * 16);
+    for (auto& file : files) {
+        for (int i = 0; i < 4000; ++i) {
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            file.add("w" + std::to_string(static_cast<int>(std::pow(200000.0, u)) - 1));
+        }
+    }
+    
+    auto run_workers = [&files](const std::function<void(size_t, const WordCounter&)>& add) {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < kWorkers; ++t) {
+            workers.emplace_back([&files, &add, t]() {
+                for (size_t i = t; i < files.size(); i += kWorkers) {
+                    add(t, files[i]);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+    auto ms_since = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    CorpusCounter sharded;
+    run_workers([&sharded](size_t, const WordCounter& file) { sharded.add(file); });
+    double sharded_ms = ms_since(start);
+    
+    start = std::chrono::steady_clock::now();
+    std::vector<WordCounter> locals(kWorkers);
+    run_workers([&locals](size_t worker, const WordCounter& file) { locals[worker].merge(file); });
+    double local_ms = ms_since(start);
+    
+    start = std::chrono::steady_clock::now();
+    for (size_t stride = 1; stride < kWorkers; stride *= 2) {
+        std::vector<std::thread> round;
+        for (size_t i = 0; i + stride < kWorkers; i += 2 * stride) {
+            round.emplace_back([&locals, i, stride]() { locals[i].merge(locals[i + stride]); });
+        }
+        for (auto& merger : round) {
+            merger.join();
+        }
+    }
+    double tree_ms = ms_since(start);
+    
+    assert(sharded.distinct_words() == locals[0].size());
+    assert(sharded.top(1)[0].count == locals[0].top(1)[0].second);
+    
+    std::cout << "✓ Corpus aggregation benchmark completed\n";
+    std::cout << "  - " << files.size() << " files, " << kWorkers << " workers, "
+              << locals[0].size() << " distinct words\n";
+    std::cout << "  - Sharded table: " << sharded_ms << "ms, nothing left to merge\n";
+    std::cout << "  - Per-worker tables: " << local_ms << "ms + " << tree_ms << "ms tree merge after the run\n";
+}
+
 int main() {
     std::cout << "=== File Processor Test Suite ===\n\n";
     
     try {
         test_text_processor_basic();
         test_text_processor_with_observer();
+        test_progress_throttling();
+        test_progress_on_exception();
+        test_streaming_chunk_boundaries();
+        test_mmap_input_mode();
+        test_range_splitting_matches_serial();
+        test_text_kernels_agree();
+        test_word_counter_allocations();
+        test_word_counter_reuse_after_large_file();
+        test_top_k_and_heavy_hitters();
+        test_corpus_counter();
+        test_processor_pool_reuse();
+        test_directory_walker();
+        test_file_batcher();
+        test_read_engine();
+        test_manifest();
+        test_deduplicator();
+        test_directory_watcher();
+        test_report_writer();
+        test_results_store();
         test_file_extension_support();
         test_large_file_processing();
         test_error_handling();
         test_json_processing();
         benchmark_text_processing();
+        benchmark_text_kernels();
+        benchmark_corpus_counter();
         
         std::cout << "\n✅ All processor tests passed!\n";
         return 0;
-        
+    
     } catch (const std::exception& e) {
         std::cerr << "❌ Test failed: " << e.what() << std::endl;
         return 1;
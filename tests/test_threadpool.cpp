@@ -102,6 +102,139 @@ void test_thread_safety() {
     std::cout << "✓ Thread safety maintained\n";
 }
 
+void test_nested_enqueue() {
+    std::cout << "Testing tasks enqueued from worker threads...\n";
+    
+    ThreadPool pool(4);
+    std::atomic<int> counter{0};
+    
+    for (int i = 0; i < 8; ++i) {
+        pool.enqueue([&pool, &counter]() {
+            for (int j = 0; j < 8; ++j) {
+                pool.enqueue([&counter]() {
+                    counter++;
+                });
+            }
+        });
+    }
+    
+    pool.wait_for_all();
+    assert(counter.load() == 64);
+    assert(pool.pending_count() == 0);
+    assert(pool.active_count() == 0);
+    
+    std::cout << "✓ Nested tasks are picked up and stolen correctly\n";
+}
+
+void test_idle_wakeup() {
+    std::cout << "Testing wakeup of parked workers...\n";
+    
+    ThreadPool pool(4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < 100; ++round) {
+        auto result = pool.enqueue([round]() {
+            return round;
+        });
+        assert(result.get() == round);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    
+    std::cout << "✓ Parked workers wake up for new tasks\n";
+    std::cout << "  - Average round trip: " << duration.count() / 100.0 << "us\n";
+}
+
+void test_bounded_pool() {
+    std::cout << "Testing bounded task queue...\n";
+    
+    {
+        ThreadPool pool(1, 2, QueueFullPolicy::FAIL);
+        std::promise<void> gate;
+        std::shared_future<void> gate_future = gate.get_future().share();
+        
+        auto blocker = pool.enqueue([gate_future]() { gate_future.wait(); });
+        while (pool.active_count() == 0) {
+            std::this_thread::yield();
+        }
+        
+        pool.enqueue([]() {});
+        pool.enqueue([]() {});
+        
+        bool rejected = false;
+        try {
+            pool.enqueue([]() {});
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        assert(rejected);
+        
+        gate.set_value();
+        pool.wait_for_all();
+    }
+    
+    {
+        ThreadPool pool(2, 4, QueueFullPolicy::BLOCK);
+        std::atomic<int> counter{0};
+        
+        for (int i = 0; i < 200; ++i) {
+            pool.enqueue([&counter]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                counter++;
+            });
+            assert(pool.pending_count() <= pool.max_pending());
+        }
+        
+        pool.wait_for_all();
+        assert(counter.load() == 200);
+    }
+    
+    std::cout << "✓ Bounded queue blocks or rejects when full\n";
+}
+
+void test_completion_order() {
+    std::cout << "Testing completion-order results...\n";
+    
+    CompletionQueue<int> completed;
+    ThreadPool pool(2);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    
+    // The first task is held back; everything behind it must still arrive.
+    pool.enqueue_to(completed, [gate_future]() {
+        gate_future.wait();
+        return 0;
+    });
+    for (int i = 1; i <= 10; ++i) {
+        pool.enqueue_to(completed, [i]() { return i; });
+    }
+    pool.enqueue_to(completed, []() -> int { throw std::runtime_error("task failed"); });
+    
+    int sum = 0;
+    int failures = 0;
+    for (int i = 0; i < 11; ++i) {
+        std::future<int> future;
+        completed.wait_and_pop(future);
+        try {
+            int value = future.get();
+            assert(value != 0);
+            sum += value;
+        } catch (const std::runtime_error&) {
+            failures++;
+        }
+    }
+    assert(sum == 55);
+    assert(failures == 1);
+    
+    gate.set_value();
+    std::future<int> last;
+    completed.wait_and_pop(last);
+    assert(last.get() == 0);
+    
+    std::cout << "✓ Results arrive as tasks finish, not in submission order\n";
+}
+
 void benchmark_performance() {
     std::cout << "Benchmarking ThreadPool performance...\n";
     
@@ -140,6 +273,97 @@ void benchmark_performance() {
               << "ms per task\n";
 }
 
+// The pool ThreadPool replaced, kept as the baseline for
+// benchmark_scaling(): one shared queue behind a mutex, and idle workers
+// poll it every millisecond.
+class SingleQueuePool {
+public:
+    explicit SingleQueuePool(size_t num_threads) : stop_(false) {
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this]() {
+                while (!stop_) {
+                    std::function<void()> task;
+                    if (tasks_.try_pop(task)) {
+                        task();
+                    } else {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+            });
+        }
+    }
+    
+    ~SingleQueuePool() {
+        stop_ = true;
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+    
+    template<class F>
+    auto enqueue(F&& f) -> std::future<decltype(f())> {
+        auto task = std::make_shared<std::packaged_task<decltype(f())()>>(std::forward<F>(f));
+        std::future<decltype(f())> result = task->get_future();
+        tasks_.push([task]() { (*task)(); });
+        return result;
+    }
+    
+private:
+    std::vector<std::thread> workers_;
+    ThreadSafeQueue<std::function<void()>> tasks_;
+    std::atomic<bool> stop_;
+};
+
+// Submits num_tasks small tasks to a fresh Pool and waits for all of
+// them; returns the elapsed time including pool start and shutdown.
+template<typename Pool>
+std::chrono::microseconds run_small_tasks(size_t num_threads, int num_tasks) {
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    {
+        Pool pool(num_threads);
+        std::vector<std::future<size_t>> futures;
+        futures.reserve(num_tasks);
+        
+        for (int i = 0; i < num_tasks; ++i) {
+            futures.emplace_back(
+                pool.enqueue([i]() {
+                    size_t hash = i;
+                    for (int j = 0; j < 2000; ++j) {
+                        hash = hash * 31 + j;
+                    }
+                    return hash;
+                })
+            );
+        }
+        
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+}
+
+void benchmark_scaling() {
+    std::cout << "Benchmarking ThreadPool scaling with many small tasks...\n";
+    std::cout << "  (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+    
+    const int num_tasks = 20000;
+    
+    for (size_t num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+        auto baseline = run_small_tasks<SingleQueuePool>(num_threads, num_tasks);
+        auto stealing = run_small_tasks<ThreadPool>(num_threads, num_tasks);
+        
+        std::cout << "  - " << num_threads << " threads: single queue " << baseline.count() / 1000.0
+                  << "ms, work-stealing " << stealing.count() / 1000.0 << "ms ("
+                  << (num_tasks * 1e6 / std::max<long>(1, stealing.count())) << " tasks/s)\n";
+    }
+    
+    std::cout << "✓ Scaling benchmark completed\n";
+}
+
 int main() {
     std::cout << "=== ThreadPool Test Suite ===\n\n";
     
@@ -149,7 +373,12 @@ int main() {
         test_exception_handling();
         test_wait_for_all();
         test_thread_safety();
+        test_nested_enqueue();
+        test_idle_wakeup();
+        test_bounded_pool();
+        test_completion_order();
         benchmark_performance();
+        benchmark_scaling();
         
         std::cout << "\n✅ All ThreadPool tests passed!\n";
         return 0;
@@ -0,0 +1,85 @@
+#include "../src/core/ResultsStore.h"
+#include <cstring>
+
+// Prints a results file written by file_processor --results-file as
+// tab-separated rows, one per file, followed by corpus totals.
+
+void print_usage() {
+    std::cout << "Usage: results_dump [OPTIONS] FILE\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -w, --words     Append each file's top words as word:count\n";
+    std::cout << "  -t, --totals    Print only the corpus totals\n";
+    std::cout << "  -h, --help      Show this help message\n";
+}
+
+int main(int argc, char* argv[]) {
+    bool show_words = false;
+    bool totals_only = false;
+    std::string path;
+    
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-w") == 0 || std::strcmp(argv[i], "--words") == 0) {
+            show_words = true;
+        } else if (std::strcmp(argv[i], "-t") == 0 || std::strcmp(argv[i], "--totals") == 0) {
+            totals_only = true;
+        } else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
+            print_usage();
+            return 0;
+        } else if (path.empty() && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << "\n";
+            print_usage();
+            return 1;
+        }
+    }
+    
+    if (path.empty()) {
+        print_usage();
+        return 1;
+    }
+    
+    ResultsReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Error: " << path << ": " << reader.error() << "\n";
+        return 1;
+    }
+    
+    if (!totals_only) {
+        std::cout << "path\tlines\twords\tcharacters\tparagraphs\tbytes\tprocessing_ms";
+        std::cout << (show_words ? "\ttop_words\n" : "\n");
+        
+        for (size_t i = 0; i < reader.size(); ++i) {
+            std::cout << reader.path(i) << '\t' << reader.lines(i) << '\t' << reader.words(i) << '\t'
+                      << reader.characters(i) << '\t' << reader.paragraphs(i) << '\t' << reader.bytes(i) << '\t'
+                      << reader.processing_ms(i);
+            if (show_words) {
+                std::cout << '\t';
+                for (size_t rank = 0; rank < reader.top_word_count(i); ++rank) {
+                    ResultsReader::WordCount word = reader.top_word(i, rank);
+                    std::cout << (rank ? " " : "") << word.word << ':' << word.count;
+                }
+            }
+            std::cout << '\n';
+        }
+        std::cout << '\n';
+    }
+    
+    auto total = [&reader](ResultsColumn column) {
+        uint64_t sum = 0;
+        for (uint64_t value : reader.column(column)) {
+            sum += value;
+        }
+        return sum;
+    };
+    
+    std::cout << "Files: " << reader.size() << " (format version " << reader.version() << ")\n";
+    std::cout << "Lines: " << total(ResultsColumn::LINES) << "\n";
+    std::cout << "Words: " << total(ResultsColumn::WORDS) << "\n";
+    std::cout << "Characters: " << total(ResultsColumn::CHARACTERS) << "\n";
+    std::cout << "Paragraphs: " << total(ResultsColumn::PARAGRAPHS) << "\n";
+    std::cout << "Bytes: " << total(ResultsColumn::BYTES) << "\n";
+    std::cout << "Processing time: " << total(ResultsColumn::PROCESSING_MS) << " ms\n";
+    
+    return 0;
+}